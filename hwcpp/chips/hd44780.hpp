@@ -15,20 +15,26 @@ private:
    typedef pin_out_from< _e > e_pin;
    typedef pin_out_from< _rs > rs_pin;
    
-   static void write4( unsigned char n ){
-      timing::wait( 10 * timing::us );
-      data_pins::set( n );
-      timing::wait( 20 * timing::us );
+   // rs and the data pins change together
+   typedef port_transaction< rs_pin, data_pins > rs_and_data;
+   
+   static void write4( unsigned char n, bool is_data = 0 ){
+      timing::wait( timing::duration::us( 10 ));
+      {
+         rs_and_data t;
+         t.template set< rs_pin >( is_data );
+         t.template set< data_pins >( n & 0x0F );
+      }
+      timing::wait( timing::duration::us( 20 ));
       e_pin::set( 1 );
-      timing::wait( 20 * timing::us );
+      timing::wait( timing::duration::us( 20 ));
       e_pin::set( 0 );
-      timing::wait( 100 * timing::us );  // enough for most instructions
+      timing::wait( timing::duration::us( 100 ));  // enough for most instructions
    }
 
    static void write8( bool is_data, unsigned char b ){
-      rs_pin::set( is_data );
-      write4( b >> 4 );
-      write4( b );
+      write4( b >> 4, is_data );
+      write4( b, is_data );
    }   
    
    static int x, y;
@@ -45,7 +51,7 @@ public:
 
    static void clear(){
       command( 0x01 );
-      timing::wait( 5 * timing::ms );
+      timing::wait( timing::duration::ms( 5 ));
       x = y = 0;
    }
    
@@ -80,14 +86,14 @@ public:
       // give LCD time to wake up
       e_pin::set( 0 );
       rs_pin::set( 0 );
-      timing::wait( 100 * timing::ms );
+      timing::wait( timing::duration::ms( 100 ));
 
       // interface initialisation: make sure the LCD is in 4 bit mode
       // (magical sequence, taken from the HD44780 datasheet)
       write4( 0x03 );
-      timing::wait(  15 * timing::ms );
+      timing::wait( timing::duration::ms( 15 ));
       write4( 0x03 );
-      timing::wait(  100 * timing::us );
+      timing::wait( timing::duration::us( 100 ));
       write4( 0x03 );
       write4( 0x02 );     // 4 bit mode
 
@@ -57,7 +57,7 @@ namespace hwcpp {
       
       // add 50ns to satisfy the minimum SCL T-high at 400kHz
       typedef typename frequency::service::template ns< 
-         frequency::half_period::duration + 50 > half_period;
+         frequency::half_period::_duration + 50 > half_period;
    
       // use the pins in an appropriate way
       // (and assert that they can be used as such)   
@@ -110,7 +110,301 @@ namespace hwcpp {
    template<> struct int_info< int > {
       static constexpr int maximum = INT_MAX;
    };
+   template<> struct int_info< long long int > {
+      static constexpr long long int maximum = LLONG_MAX;
+   };
+   
+
+   // =======================================================================
+   //
+   // the number of bits needed to store n
+   //
+   // =======================================================================
+
+   constexpr int _bits_needed( unsigned int n ){
+      return ( n == 0 ) ? 0 : 1 + _bits_needed( n >> 1 );
+   }
+
+
+   // =======================================================================
+   //
+   // division by a constant without a divide instruction
+   //
+   // The Cortex-M0 has no divide instruction, so a run-time 64-bit 
+   // division is a slow library call. constant_divider< d >::divide( x )
+   // divides by a compile-time constant d using only multiplications 
+   // and shifts: x is divided in k-bit digits (long division), each 
+   // digit step uses a reciprocal multiplication that is exact for 
+   // all its possible dividends. A power of 2 is a shift.
+   //
+   // =======================================================================
+   
+   // ( x * m ) >> s, a digit step of constant_divider<>
+   constexpr unsigned long long _reciprocal_step( 
+      unsigned long long x, 
+      unsigned long long m, 
+      int s 
+   ){
+      return ( x * m ) >> s;
+   }
+   
+   template< unsigned long long d >
+   struct constant_divider {
+   
+      static_assert( 
+         ( d > 0 ) && ( d < ( 1ULL << 30 )), 
+         "constant_divider<> divisor must be 1 .. 2^30 - 1" 
+      );
    
+      typedef unsigned long long ull;
+      
+      static constexpr bool power_of_2 = ( d & ( d - 1 )) == 0;
+      static constexpr int d_bits = _bits_needed( d );
+      
+      // bits per digit, bits of a digit step dividend, and shift
+      static constexpr int k = ( 31 - d_bits < 16 ) ? 31 - d_bits : 16;
+      static constexpr int n = d_bits + k;
+      static constexpr int s = n + d_bits;
+      static constexpr int steps = ( 64 + k - 1 ) / k;
+      
+      // the reciprocal, rounded up
+      static constexpr ull m = ( 1ULL << s ) / d + 1;
+      
+      // A digit step divides r * 2^k + digit < d * 2^k. The rounded up 
+      // reciprocal overestimates most at the largest of those with 
+      // remainder d - 1, which is the largest one, so when that one 
+      // (and the ones at the other end) equal a real division, all do.
+      static constexpr ull last = d * ( 1ULL << k ) - 1;
+      static_assert( 
+         power_of_2 || (
+            ( _reciprocal_step( last, m, s ) == last / d )
+            && ( _reciprocal_step( last - ( d - 1 ), m, s ) == last / d )
+            && ( _reciprocal_step( last - d, m, s ) == last / d - 1 )
+            && ( _reciprocal_step( d - 1, m, s ) == 0 )
+            && ( _reciprocal_step( d, m, s ) == 1 )
+         ),
+         "constant_divider<> reciprocal is not exact" 
+      );
+      
+      // x / d for x < d * 2^k
+      static constexpr ull step( ull x ){
+         return _reciprocal_step( x, m, s );
+      }
+      
+      static constexpr ull digit( ull x, int i ){
+         return ( x >> ( k * i )) & (( 1ULL << k ) - 1 );
+      }
+      
+      // the quotient of the digits i-1 .. 0 of x, with remainder r 
+      // of the higher digits
+      static constexpr ull digits( ull x, int i, ull r ){
+         return ( i == 0 ) 
+            ? 0 
+            : ( step(( r << k ) | digit( x, i - 1 )) << ( k * ( i - 1 )))
+               | digits( 
+                  x, 
+                  i - 1, 
+                  (( r << k ) | digit( x, i - 1 )) 
+                     - d * step(( r << k ) | digit( x, i - 1 ))
+               );
+      }
+      
+      static constexpr ull divide( ull x ){
+         return power_of_2 
+            ? ( x >> ( d_bits - 1 )) 
+            : digits( x, steps, 0 );
+      }
+      
+      // signed, rounds towards 0 like /; the magnitude is negated as 
+      // an ull, because - LLONG_MIN does not fit in a long long, and 
+      // d == 1 is the only divisor for which LLONG_MIN / d does not fit
+      static constexpr long long int divide( long long int x ){
+         return ( d == 1 )
+            ? x
+            : ( x < 0 ) 
+               ? - (long long int) divide( 0ULL - (ull) x ) 
+               : (long long int) divide( (ull) x );
+      }
+      
+      static constexpr unsigned int divide( unsigned int x ){
+         return (unsigned int) divide( (ull) x );
+      }
+      
+      static constexpr int divide( int x ){
+         return (int) divide( (long long int) x );
+      }
+   };
+   
+   
+   // =======================================================================
+   //
+   // single-producer single-consumer ring buffer
+   //
+   // spsc_ring< T, N > holds up to N (a power of 2) elements. One side 
+   // (for instance an interrupt handler) pushes, the other side pops. 
+   // Each side writes only its own free-running index, so no shared 
+   // counter is needed, and neither interrupts need to be disabled nor 
+   // atomic instructions (which the Cortex-M0 lacks) are used. A side 
+   // publishes its index only after the elements are written or read.
+   //
+   // push_span( p ) and pop_span( p ) return the number of elements
+   // that can be written or read contiguously at p, without copying;
+   // push_commit( n ) and pop_commit( n ) then publish n of them.
+   //
+   // There is no constructor, so a static ring is zero-initialized
+   // (empty) before any code runs. clear() empties it, when neither 
+   // side is using it.
+   //
+   // =======================================================================
+   
+   template< class T, unsigned int N >
+   struct spsc_ring {
+   
+      static_assert( 
+         ( N > 0 ) && (( N & ( N - 1 )) == 0 ), 
+         "spsc_ring<> size must be a power of 2" 
+      );
+      
+      static constexpr unsigned int size = N;
+      
+      T buffer[ N ];
+      
+      // written only by the producer and by the consumer
+      volatile unsigned int head;
+      volatile unsigned int tail;
+      
+      void clear(){
+         head = 0;
+         tail = 0;
+      }
+      
+      unsigned int count() const {
+         return head - tail;
+      }
+      
+      bool empty() const {
+         return head == tail;
+      }
+      
+      bool full() const {
+         return head - tail == N;
+      }
+      
+      // producer side
+      
+      unsigned int push_span( T *& p ){
+         unsigned int h = head;
+         unsigned int room = N - ( h - tail );
+         unsigned int end = N - ( h & ( N - 1 ));
+         p = &buffer[ h & ( N - 1 ) ];
+         return ( room < end ) ? room : end;
+      }
+      
+      void push_commit( unsigned int n ){
+         
+         // the elements must be written before they are published
+         __sync_synchronize();
+         head = head + n;
+      }
+      
+      bool push( const T & x ){
+         T * p;
+         if( push_span( p ) == 0 ){
+            return false;
+         }
+         *p = x;
+         push_commit( 1 );
+         return true;
+      }
+      
+      // push up to n elements, return the number pushed
+      unsigned int push_n( const T * source, unsigned int n ){
+         unsigned int done = 0;
+         while( done < n ){
+            T * p;
+            unsigned int m = push_span( p );
+            if( m == 0 ){
+               break;
+            }
+            if( m > n - done ){
+               m = n - done;
+            }
+            for( unsigned int i = 0; i < m; i++ ){
+               p[ i ] = source[ done + i ];
+            }
+            push_commit( m );
+            done += m;
+         }
+         return done;
+      }
+      
+      // consumer side
+      
+      unsigned int pop_span( T *& p ){
+         unsigned int t = tail;
+         unsigned int used = head - t;
+         unsigned int end = N - ( t & ( N - 1 ));
+         
+         // the elements must be read after their index
+         __sync_synchronize();
+         p = &buffer[ t & ( N - 1 ) ];
+         return ( used < end ) ? used : end;
+      }
+      
+      void pop_commit( unsigned int n ){
+      
+         // the elements must be read before they are released
+         __sync_synchronize();
+         tail = tail + n;
+      }
+      
+      bool pop( T & x ){
+         T * p;
+         if( pop_span( p ) == 0 ){
+            return false;
+         }
+         x = *p;
+         pop_commit( 1 );
+         return true;
+      }
+      
+      // pop up to n elements, return the number popped
+      unsigned int pop_n( T * destination, unsigned int n ){
+         unsigned int done = 0;
+         while( done < n ){
+            T * p;
+            unsigned int m = pop_span( p );
+            if( m == 0 ){
+               break;
+            }
+            if( m > n - done ){
+               m = n - done;
+            }
+            for( unsigned int i = 0; i < m; i++ ){
+               destination[ done + i ] = p[ i ];
+            }
+            pop_commit( m );
+            done += m;
+         }
+         return done;
+      }
+   };
+   
+   
+   // =======================================================================
+   //
+   // compile-time check whether two types are the same
+   //
+   // =======================================================================
+
+   template< class a, class b > struct same_type {
+      static constexpr bool value = false;
+   };
+
+   template< class a > struct same_type< a, a > {
+      static constexpr bool value = true;
+   };
+
 
    // =======================================================================
    //
@@ -12,11 +12,21 @@
 
 namespace hwcpp {
 
+   // A channel can provide put_n() and get_n(), to transfer a block 
+   // of chars faster than char by char, and mark that with has_put_n
+   // or has_get_n. Users call channel_put_n< channel >::put_n() and 
+   // channel_get_n< channel >::get_n(), which use put() and get() 
+   // when the channel doesn't.
+
    struct channel_in_archetype {
       typedef void has_channel_in;
       static void init();
       static bool get_will_block();
       static char get();
+      
+      // optional, typedef void has_get_n;
+      // get n chars, blocks until all are received
+      static void get_n( char * s, unsigned int n );
    };   
 
    struct channel_out_archetype {
@@ -24,7 +34,45 @@ namespace hwcpp {
       static void init();
       static bool put_will_block();
       static void put( char c );
+      
+      // optional, typedef void has_put_n;
+      // put n chars, blocks until all are accepted
+      static void put_n( const char * s, unsigned int n );
    };   
+   
+   // fallback: put the chars one by one
+   template< class channel, class dummy = void >
+   struct channel_put_n {
+      static void put_n( const char * s, unsigned int n ){
+         while( n-- > 0 ){
+            channel::put( *s++ );
+         }
+      }
+   };
+   
+   template< class channel >
+   struct channel_put_n< channel, typename channel::has_put_n > {
+      static void put_n( const char * s, unsigned int n ){
+         channel::put_n( s, n );
+      }
+   };
+   
+   // fallback: get the chars one by one
+   template< class channel, class dummy = void >
+   struct channel_get_n {
+      static void get_n( char * s, unsigned int n ){
+         while( n-- > 0 ){
+            *s++ = channel::get();
+         }
+      }
+   };
+   
+   template< class channel >
+   struct channel_get_n< channel, typename channel::has_get_n > {
+      static void get_n( char * s, unsigned int n ){
+         channel::get_n( s, n );
+      }
+   };
 
    struct channel_in_out_archetype :
       public channel_in_archetype,
@@ -37,8 +85,15 @@ namespace hwcpp {
       static void init(){}
       static bool put_will_block(){ return false; }
       static void put( char c ){}
+      
+      typedef void has_put_n;
+      static void put_n( const char * s, unsigned int n ){}
    };
    
+   // buffer the chars written to a channel: put() stores the char
+   // in a ring buffer (or counts it in overflow_count when the buffer
+   // is full), poll() passes the buffered chars on as far as the
+   // channel accepts them. buffer_size must be a power of 2.
    template< 
       class channel, 
       unsigned int buffer_size,
@@ -49,51 +104,85 @@ namespace hwcpp {
    {
    private:
    
-      static char buffer[ buffer_size ];
-      static int read_index;
-      static int write_index;
-      static int n_buffered;   
+      static spsc_ring< char, buffer_size > buffer;
       
    public:
    
       static int overflow_count;
       
       static void init(){
-         read_index = 0; 
-         write_index = 0;
+         buffer.clear();
          overflow_count = 0;
-         n_buffered = 0;      
       }
       
       static void put( char c ){
-         if( n_buffered < buffer_size ){
-            buffer[ write_index ] = c;
-            if( ++write_index == buffer_size ){
-               write_index = 0;
-            }   
-            n_buffered++;
-         } else {
+         if( ! buffer.push( c ) ){
             overflow_count++;
          }
          poll();
       }
+      
+      typedef void has_put_n;
+      static void put_n( const char * s, unsigned int n ){
+         overflow_count += n - buffer.push_n( s, n );
+         poll();
+      }
    
       static bool put_will_block(){
          return false;
       }        
       
       static void poll(){
-         if( ( n_buffered > 0 ) && ! channel::put_will_not_block() ){
-            channel::put( buffer[ read_index ] );
-            if( ++read_index == buffer_size ){
-               read_index = 0;
-           }
-           n_buffered--;
+         char c;
+         while( ( ! channel::put_will_block() ) && buffer.pop( c ) ){
+            channel::put( c );
          }
       }        
    
    };   
    
+   template< class c, unsigned int s, class i >
+      spsc_ring< char, s > channel_out_buffer< c, s, i >::buffer;
+   
+   template< class c, unsigned int s, class i >
+      int channel_out_buffer< c, s, i >::overflow_count;
+   
+   // =======================================================================
+   //
+   // uart_out
+   //
+   // Send asynchronous serial data (8 data bits, no parity, 2 stop
+   // bits) on a pin. The moment of each bit edge is an offset from the 
+   // start of the char that is computed at compile time, in ns rounded 
+   // to a tick, so the rounding errors do not add up over the bits. 
+   // Only the edges where the level changes are waited for.
+   //
+   // =======================================================================
+   
+   template< class uart, unsigned int i, unsigned int n >
+   struct _uart_out_bits {
+      static void put( 
+         const typename uart::moment start, 
+         unsigned int frame, 
+         bool level 
+      ){
+         bool bit = ( frame >> i ) & 0x01;
+         if( bit != level ){
+            uart::template edge< i >( start, bit );
+         }
+         _uart_out_bits< uart, i + 1, n >::put( start, frame, bit );
+      }
+   };
+   
+   template< class uart, unsigned int n >
+   struct _uart_out_bits< uart, n, n > {
+      static void put( 
+         const typename uart::moment start, 
+         unsigned int frame, 
+         bool level 
+      ){}
+   };
+   
    template< 
       class _pin, 
       class timing, 
@@ -106,10 +195,30 @@ namespace hwcpp {
       HARDWARE_REQUIRE_ARCHETYPE( timing, has_timing );
    
       typedef pin_out_from< _pin > pin;
-      static constexpr typename timing::duration interval = 
-         timing::duration::us( MHz / baudrate );
-      static constexpr typename timing::duration margin = 
-         timing::duration::us( 1 );
+      typedef typename timing::moment moment;
+      
+      // the start of bit i, in ns after the start of the char
+      static constexpr unsigned long long edge_ns( unsigned int i ){
+         return ( 1000000000ULL * i ) / baudrate;
+      }
+      
+      // the start of bit i, as a duration in ticks, 
+      // so an edge moment is only an add
+      template< unsigned int i >
+      struct edge_offset {
+         static constexpr typename timing::duration value =
+            timing::duration::ns( edge_ns( i ));
+      };
+      
+      // set the pin at the start of bit i
+      template< unsigned int i >
+      static void edge( const moment start, bool b ){
+         timing::wait( 
+            start + edge_offset< i >::value, 
+            timing::duration::us( 1 ) 
+         );
+         pin::set( b );
+      }
                 
       static void init(){
          pin::init();
@@ -121,25 +230,184 @@ namespace hwcpp {
          return false;
       }
       
-      static void send( typename timing::moment &t, bool b ){
-         pin::set( b );
-         t += interval;
-         timing::wait( t, margin );         
+      static void put( char c ){
+      
+         // start bit, data bits, stop bits
+         unsigned int frame = ( 0x300 | (unsigned char) c ) << 1;
+         
+         moment start = timing::now();
+         pin::set( 0 );
+         _uart_out_bits< uart_out, 1, 11 >::put( start, frame, 0 );
+         
+         // the end of the stop bits
+         timing::wait( 
+            start + edge_offset< 11 >::value, 
+            timing::duration::us( 1 ) 
+         );
+      }
+   };   
+   
+   template< class p, class t, unsigned int b >
+   template< unsigned int i >
+      constexpr typename t::duration 
+         uart_out< p, t, b >::edge_offset< i >::value;
+   
+   // =======================================================================
+   //
+   // uart_in
+   //
+   // Receive asynchronous serial data (8 data bits, no parity, 1 stop
+   // bit) on a pin by sampling it. poll() checks for a start bit, a 
+   // falling edge after the line was seen idle (high). When there is 
+   // one it receives the char, sampling each bit three times around its 
+   // middle (at moments relative to the start edge, so the errors of
+   // the bits do not add up) and taking the majority, and stores it in 
+   // a ring buffer of buffer_size chars. A char with a stop bit that 
+   // is not high is dropped and counted in framing_errors, a char that 
+   // finds the buffer full is counted in overflows.
+   //
+   // get() and get_will_block() call poll(), so they take the time of 
+   // a char when a start bit has arrived. The edge is found only as 
+   // fast as poll() is called, the delay shifts all samples.
+   //
+   // =======================================================================
+   
+   template< class uart, unsigned int i, unsigned int n >
+   struct _uart_in_bits {
+      static unsigned int get( const typename uart::moment start ){
+         return ( uart::template vote< i >( start ) << ( i - 1 ))
+            | _uart_in_bits< uart, i + 1, n >::get( start );
+      }
+   };
+   
+   template< class uart, unsigned int n >
+   struct _uart_in_bits< uart, n, n > {
+      static unsigned int get( const typename uart::moment start ){
+         return 0;
       }
+   };
+   
+   template< 
+      class _pin, 
+      class timing,
+      unsigned int baudrate = HWCPP_BAUDRATE,
+      unsigned int buffer_size = 16
+   >
+   struct uart_in :
+      public channel_in_archetype 
+   {
+   
+      HARDWARE_REQUIRE_ARCHETYPE( timing, has_timing );
+   
+      typedef pin_in_from< _pin > pin;
+      typedef typename timing::moment moment;
       
-      static void put( char c ){
-         auto t = timing::now();
-         send( t, 0 );
-
-         for( int i = 0; i < 8; i++ ){
-            send( t, c & 0x01 );
-            c = c >> 1;
+      // the chars that were dropped
+      static unsigned int framing_errors;
+      static unsigned int overflows;
+      
+   private:
+   
+      static spsc_ring< char, buffer_size > buffer;
+      static bool idle;
+      
+      typedef unsigned long long int ull;
+      
+      // the moment (in ns after the start edge) of sample s (0, 1, 2)
+      // of bit i (0 is the start bit), samples are 1/8 bit apart
+      static constexpr ull sample_ns( unsigned int i, int s ){
+         return ( 1000000000ULL * ( 8 * ( 2 * i + 1 ) + 2 * ( s - 1 )))
+            / ( 16ULL * baudrate );
+      }
+      
+      // the same as a duration in ticks
+      template< unsigned int i, int s >
+      struct sample_offset {
+         static constexpr typename timing::duration value =
+            timing::duration::ns( sample_ns( i, s ));
+      };
+      
+      static unsigned int sample( const moment t ){
+         timing::wait( t, timing::duration::us( 1 ));
+         return pin::get() ? 1 : 0;
+      }
+      
+   public:
+   
+      // the majority of the three samples of bit i
+      template< unsigned int i >
+      static unsigned int vote( const moment start ){
+         unsigned int n = 
+              sample( start + sample_offset< i, 0 >::value )
+            + sample( start + sample_offset< i, 1 >::value )
+            + sample( start + sample_offset< i, 2 >::value );
+         return ( n >= 2 ) ? 1 : 0;
+      }
+   
+      static void init(){
+         pin::init();
+         timing::init();
+         buffer.clear();
+         idle = false;
+         framing_errors = 0;
+         overflows = 0;
+      }
+      
+      // receive a char when a start bit has arrived
+      static void poll(){
+         if( pin::get() ){
+            idle = true;
+            return;
+         }
+         if( ! idle ){
+            return;
          }
+         moment start = timing::now();
          
-         send( t, 1 );
-         send( t, 1 );
-
+         // a start bit that is gone at its middle was a glitch
+         if( vote< 0 >( start ) != 0 ){
+            return;
+         }
+         
+         char c = _uart_in_bits< uart_in, 1, 9 >::get( start );
+         idle = ( vote< 9 >( start ) != 0 );
+         if( ! idle ){
+            framing_errors++;
+         } else if( ! buffer.push( c )){
+            overflows++;
+         }
       }
-   };   
+      
+      static bool get_will_block(){
+         poll();
+         return buffer.empty();
+      }
+      
+      static char get(){
+         char c;
+         while( ! buffer.pop( c )){
+            poll();
+         }
+         return c;
+      }
+   };
+   
+   template< class p, class t, unsigned int b, unsigned int s >
+      unsigned int uart_in< p, t, b, s >::framing_errors;
+   
+   template< class p, class t, unsigned int b, unsigned int s >
+      unsigned int uart_in< p, t, b, s >::overflows;
+   
+   template< class p, class t, unsigned int b, unsigned int s >
+      spsc_ring< char, s > uart_in< p, t, b, s >::buffer;
+   
+   template< class p, class t, unsigned int b, unsigned int s >
+      bool uart_in< p, t, b, s >::idle;
+   
+   template< class p, class t, unsigned int b, unsigned int s >
+   template< unsigned int i, int x >
+      constexpr typename t::duration 
+         uart_in< p, t, b, s >::sample_offset< i, x >::value;
+   
    
 }; // namespace hwcpp
\ No newline at end of file
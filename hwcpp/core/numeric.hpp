@@ -108,7 +108,7 @@ namespace hwcpp {
       }
       
       static void set_value( unsigned char value, bool point = false ){
-         set_segments( segments[ value ] | point ? 0x80 : 0x00 );
+         set_segments( segments( value ) | ( point ? 0x80 : 0x00 ));
       }
       
    };   
@@ -14,6 +14,10 @@
 #ifdef BMPTK_EMBEDDED_IOSTREAM
 
 namespace hwcpp {
+
+// in channels.hpp
+template< class channel, class dummy > struct channel_put_n;
+
 namespace io {
 
    constexpr char endl = '\n';
@@ -108,6 +112,9 @@ namespace io {
       
       void (*fputc)(char c );
       
+      // when not nullptr: write a block of chars
+      void (*fputs)(const char *s, unsigned int n );
+      
       // not copyable
       ostream( const ostream& ) = delete;
       ostream& operator=( const ostream& ) = delete;      
@@ -184,17 +191,20 @@ namespace io {
          show_pos( false ),
          bool_alpha( false ),
          show_base( false ),
-         fputc( nullptr )
+         fputc( nullptr ),
+         fputs( nullptr )
       {}
       
       void use( void f(char c ) ){
          fputc = f;
+         fputs = nullptr;
       }
       
       template< class channel >
       void connect(){
          channel::init();
-         use( channel::put );
+         fputc = channel::put;
+         fputs = channel_put_n< channel, void >::put_n;
       }   
       
       void putc( char c ){
@@ -202,6 +212,16 @@ namespace io {
 		     fputc( c );
          }         
       }
+      
+      void putn( const char *s, int n ){
+         if( fputs != nullptr ){
+            fputs( s, n );
+         } else {
+            while( n-- > 0 ){
+               putc( *s++ );
+            }
+         }
+      }
        
       ostream & operator<< ( char c ){ 
          putc( c ); 
@@ -308,14 +328,13 @@ namespace io {
       }      
   
       friend ostream & operator<< ( ostream & stream, const char *s ){
+         int n = strlen( s );
          if( stream.must_align_right()){
-            stream.filler( stream.width() - strlen( s )); 
+            stream.filler( stream.width() - n ); 
          }       
-         for( const char *p = s; *p != '\0'; p++ ){
-            stream << *p;
-         }
+         stream.putn( s, n );
          if(0)if( ! stream.must_align_right()){
-           stream.filler( stream.width() - strlen( s )); 
+           stream.filler( stream.width() - n ); 
          }  
          stream.width( 0 );
          return stream;
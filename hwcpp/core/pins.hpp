@@ -46,7 +46,75 @@ namespace hwcpp {
       static bool get();
       static void set( bool value );
    };
-   
+
+
+   // =======================================================================
+   //
+   // Port registers
+   //
+   // A port register is the (GPIO data) register that holds the level
+   // of a number of pins. Writing to it is done through set_masked(),
+   // which changes only the bits that are 1 in mask. A target that has
+   // hardware support for masked writes (like the LPC1114 GPIO DATA
+   // address masking) can do this in a single store.
+   //
+   // A pin_in, pin_out or pin_in_out can declare the port register
+   // and the bit in that register that backs it. This is a promise
+   // that set() and get() on the pin are equivalent to writing and
+   // reading that bit in the register, so the port adapters can
+   // combine the pins of one register into a single write or read.
+   //
+   // =======================================================================
+
+   struct port_register_archetype {
+      typedef void has_port_register;
+      typedef unsigned int value_type;
+      static value_type get();
+      static void set_masked( value_type mask, value_type value );
+   };
+
+   template< class _register, int _bit >
+   struct pin_port_register_archetype {
+      typedef void has_port_register_bit;
+      typedef _register port_register;
+      static constexpr int port_register_bit = _bit;
+   };
+
+   // the port register information of a pin, known == false when
+   // the pin doesn't declare one
+   template< class pin, class dummy = void >
+   struct port_register_of {
+      static constexpr bool known = false;
+      typedef void port_register;
+      static constexpr int bit = 0;
+   };
+
+   template< class pin >
+   struct port_register_of<
+      pin,
+      typename pin::has_port_register_bit
+   > {
+      static constexpr bool known = true;
+      typedef typename pin::port_register port_register;
+      static constexpr int bit = pin::port_register_bit;
+   };
+
+   // inherit this to pass the port register of pin on to a
+   // pin that delegates set() and get() unmodified
+   template< class pin, class dummy = void >
+   struct port_register_forward {};
+
+   template< class pin >
+   struct port_register_forward<
+      pin,
+      typename pin::has_port_register_bit
+   > :
+      public pin_port_register_archetype<
+         typename pin::port_register,
+         pin::port_register_bit
+      >
+   {};
+
    // =======================================================================
    //
    // Dummy
@@ -186,7 +254,8 @@ namespace hwcpp {
       pin, 
       typename pin::has_pin_in 
    > : 
-      public pin_in_archetype 
+      public pin_in_archetype,
+      public port_register_forward< pin >
    {
       static void init(){ pin::init(); }
       static bool get(){ return pin::get(); }
@@ -198,7 +267,8 @@ namespace hwcpp {
       pin, 
       typename pin::has_pin_in_out
    > : 
-      public pin_in_archetype 
+      public pin_in_archetype,
+      public port_register_forward< pin >
    {
    
       static void init() {
@@ -257,7 +327,8 @@ namespace hwcpp {
       pin,
       typename pin::has_pin_out 
    > : 
-      public pin_out_archetype
+      public pin_out_archetype,
+      public port_register_forward< pin >
    {
       static void init(){ pin::init(); }
       static void set( bool x ){ pin::set( x ); }   
@@ -269,7 +340,8 @@ namespace hwcpp {
       pin, 
       typename pin::has_pin_in_out
    > :
-      public pin_out_archetype 
+      public pin_out_archetype,
+      public port_register_forward< pin >
    {
    
       static void init(){
@@ -329,7 +401,8 @@ namespace hwcpp {
       pin, 
       typename pin::has_pin_in_out 
    > :
-      public pin_in_out_archetype 
+      public pin_in_out_archetype,
+      public port_register_forward< pin >
    {
       static void init(){ pin::init(); }
       static bool get(){ return pin::get(); }   
@@ -654,12 +727,99 @@ namespace hwcpp {
    //
    // debounce
    //
+   // Remove the contact bounce from a pin_in or port_in (or a pin or
+   // port that can be used as such). A clock callback of the timing
+   // service samples the input every interval. The debounced level of 
+   // a bit changes when the input had the new level for stable 
+   // consecutive samples.
+   //
+   // The filter is a vertical counter: bit i of count[ 0 .. ] is the
+   // number of samples that input bit i differed from the debounced 
+   // level, so all bits of a port are filtered by a few bitwise 
+   // operations per sample.
+   //
+   // get() returns the debounced level, pressed() and released() 
+   // return the bits that went high (low) since their previous call.
+   //
    // =======================================================================
    
+   // below
+   template< typename... arguments > struct port_in_from_pins;
+   
+   // fallback: compiler error
    template< 
-      class t, 
+      class unsupported, 
+      class timing,
+      class interval = typename timing::template ms< 5 >,
+      unsigned int stable = 4,
       class dummy = void 
-   > struct debounce;
+   > struct debounce {
+      static_assert( 
+         sizeof( unsupported ) == 0, 
+         "debounce<> requires a pin_in, pin_in_out, pin_oc, "
+         "or a corresponding port" 
+      );
+   };
+   
+   // from a pin_in: debounce it as a one-pin port
+   template< 
+      class pin, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      pin, 
+      timing, 
+      interval, 
+      stable, 
+      typename pin::has_pin_in 
+   > :
+      public pin_in_archetype 
+   {
+      typedef debounce< 
+         port_in_from_pins< pin >, timing, interval, stable 
+      > port;
+   
+      static void init(){ port::init(); }
+      static bool get(){ return port::get() & 0x01; }
+      static bool pressed(){ return port::pressed() & 0x01; }
+      static bool released(){ return port::released() & 0x01; }
+   };
+   
+   // from a pin_in_out: convert it to a pin_in
+   template< 
+      class pin, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      pin, 
+      timing, 
+      interval, 
+      stable, 
+      typename pin::has_pin_in_out 
+   > :
+      public debounce< pin_in_from< pin >, timing, interval, stable >
+   {};
+   
+   // from a pin_oc: convert it to a pin_in
+   template< 
+      class pin, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      pin, 
+      timing, 
+      interval, 
+      stable, 
+      typename pin::has_pin_oc 
+   > :
+      public debounce< pin_in_from< pin >, timing, interval, stable >
+   {};
    
    
    // =======================================================================
@@ -727,133 +887,997 @@ namespace hwcpp {
    
    // =======================================================================
    //
-   // Blinking
+   // edge_capture
+   //
+   // Record the edges of a pin_in or port_in (or a pin or port that 
+   // can be used as such). Each call to sample() reads the input; when
+   // it shows an edge of the selected kind (rising, falling, or both)
+   // an event with the time (timing::now()), the new value, and the 
+   // mask of the bits that have such an edge is stored in a ring 
+   // buffer (an spsc_ring) of n events. get() removes the oldest event.
+   //
+   // sample() is the only writer and get() the only reader of the
+   // buffer, so sample() can be called from a callback or interrupt
+   // while the main code calls get(). When the buffer is full an 
+   // event is dropped and overflows is incremented.
    //
    // =======================================================================
    
-   template< typename arg_timing >
-   struct waiting_from : public arg_timing {
-      
-      
-   };
-     
+   enum class edge_mode { rising, falling, both };
+   
+   // fallback: compiler error
    template< 
-      typename arg_pin, 
-      typename timing
-   > struct blink { 
-     
-      typedef pin_out_from< arg_pin > pin;
-      // typedef waiting_from< arg_timing > timing;
-      
-      typedef typename timing::duration duration;
-        
-      static void run( const duration t = duration::ms( 500 )){    
-         timing::init();
-         pin::init(); 
-         for(;;){
-            pin::set( 1 );
-            timing::wait( t / 2 );
-            pin::set( 0 );
-            timing::wait( t / 2 );
-         }
-      }
+      class unsupported, 
+      class timing,
+      unsigned int n = 32,
+      edge_mode mode = edge_mode::both,
+      class dummy = void 
+   > struct edge_capture {
+      static_assert( 
+         sizeof( unsupported ) == 0, 
+         "edge_capture<> requires a pin_in, pin_in_out, pin_oc, "
+         "or a corresponding port" 
+      );
    };
    
-
+   // from a pin: capture it as a one-pin port
+   template< 
+      class pin, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< pin, timing, n, mode, typename pin::has_pin_in > :
+      public edge_capture< port_in_from_pins< pin >, timing, n, mode >
+   {};
+   
+   template< 
+      class pin, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< 
+      pin, timing, n, mode, typename pin::has_pin_in_out 
+   > :
+      public edge_capture< port_in_from_pins< pin >, timing, n, mode >
+   {};
+   
+   template< 
+      class pin, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< pin, timing, n, mode, typename pin::has_pin_oc > :
+      public edge_capture< port_in_from_pins< pin >, timing, n, mode >
+   {};
+   
+   
    // =======================================================================
    //
-   // ...
+   // cached
    //
-   // =======================================================================
-     
-   // used to select a pin from a port
-   template< class port, unsigned int n > 
-      struct _pin_select : public _pin_select< 
-         typename port::tail, n - 1 > {};
-   template< class port >
-      struct _pin_select< port, 0 > : public port::_pin {};   
-      
-   // the maximum value (all bits 1) of an unsigned integer
-   template< class t, int n > 
-      struct _all_ones { 
-         static constexpr t value = 
-            ( _all_ones< t, n - 1 >::value << 8 ) | 0xFF; };
-   template< class t > 
-      struct _all_ones< t, 0 > {
-         static constexpr t value = 0x00; };
-   template< class t > 
-      struct all_ones : public _all_ones< t, sizeof( t ) >{};
-    
-   
-   // =======================================================================
+   // Remember the last value written to a pin_out (or a pin or port 
+   // that can be used as such), and skip a set() that would write
+   // the same value again. This saves bus transactions on pins that
+   // are on an I/O extender or shift register. force_flush() writes
+   // the remembered value again, for instance after the chip was 
+   // reset. get() and the direction calls are passed on unmodified.
    //
-   // port_in_from
+   // When HWCPP_CACHED_STATISTICS is defined as 1 the number of 
+   // skipped (hits) and performed (misses) writes is counted.
    //
    // =======================================================================
    
-   // fallback: compile-time error
+   #ifndef HWCPP_CACHED_STATISTICS
+      #define HWCPP_CACHED_STATISTICS 0
+   #endif
+   
+   // the remembered value of a cached<> pin or port
+   template< class owner, class value_type >
+   struct _cached_shadow {
+      static value_type value;
+      static bool valid;
+      
+      #if HWCPP_CACHED_STATISTICS
+         static unsigned int hits;
+         static unsigned int misses;
+      #endif
+      
+      static void clear(){
+         valid = false;
+         #if HWCPP_CACHED_STATISTICS
+            hits = 0;
+            misses = 0;
+         #endif
+      }
+      
+      // remember x, return whether it must be written
+      static bool update( value_type x ){
+         if( valid && ( x == value )){
+            #if HWCPP_CACHED_STATISTICS
+               hits++;
+            #endif
+            return false;
+         }
+         #if HWCPP_CACHED_STATISTICS
+            misses++;
+         #endif
+         value = x;
+         valid = true;
+         return true;
+      }
+   };
+   
+   template< class o, class v > v _cached_shadow< o, v >::value;
+   template< class o, class v > bool _cached_shadow< o, v >::valid;
+   
+   #if HWCPP_CACHED_STATISTICS
+      template< class o, class v > unsigned int _cached_shadow< o, v >::hits;
+      template< class o, class v > unsigned int _cached_shadow< o, v >::misses;
+   #endif
+   
+   // fallback: compiler error
    template< 
       class unsupported, 
       class dummy = void 
-   > 
-   struct port_in_from {
+   > struct cached {
       static_assert( 
          sizeof( unsupported ) == 0, 
-         "port_in_from<> requires "
-         "a port_in, port_in_out, or port_oc" 
+         "cached<> requires a pin_out, pin_in_out, pin_oc, "
+         "or a corresponding port" 
       );
    };
    
-   // from itself: delegate
-   template< class port >
-   struct port_in_from < 
-      port, 
-      typename port::has_port_in 
-   > 
-   : public 
-      port_in< port::n_pins >
+   // from a pin_out: skip a set() of the same value
+   template< class pin >
+   struct cached< 
+      pin, 
+      typename pin::has_pin_out 
+   > :
+      public pin_out_archetype 
    {
-      typedef typename port::value_type value_type;
-      static void init(){ port::init(); }
-      static value_type get(){ return port::get(); }    
+      typedef _cached_shadow< cached, bool > shadow;
+      
+      static void init(){ 
+         pin::init(); 
+         shadow::clear();
+      }
+      
+      static void set( bool x ){
+         if( shadow::update( x )){
+            pin::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            pin::set( shadow::value );
+         }
+      }
    };
    
-   // from a port_in_out: init sets the direction to input
-   template< class port >
-   struct port_in_from <  
-      port, 
-      typename port::has_port_in_out
-   > 
-   : public 
-      port_in< port::n_pins > 
+   // from a pin_in_out: skip a set() of the same value
+   template< class pin >
+   struct cached< 
+      pin, 
+      typename pin::has_pin_in_out 
+   > :
+      public pin_in_out_archetype 
    {
-      typedef typename port::value_type value_type;
-   
-      static void init(){
-         port::init();
-         port::direction_set_input();
-      }   
+      typedef _cached_shadow< cached, bool > shadow;
       
-      static value_type get(){ return port::get(); }
+      static void init(){ 
+         pin::init(); 
+         shadow::clear();
+      }
+      
+      static void direction_set_input(){ pin::direction_set_input(); }
+      static void direction_set_output(){ pin::direction_set_output(); }
+      static bool get(){ return pin::get(); }
+      
+      static void set( bool x ){
+         if( shadow::update( x )){
+            pin::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            pin::set( shadow::value );
+         }
+      }
    };
    
-   // from a port_oc: init sets the pins high
-   template< class port >
-   struct port_in_from <  
-      port, 
-      typename port::has_port_oc
-   >  
-   : public 
-      port_in< port::n_pins > 
+   // from a pin_oc: skip a set() of the same value
+   template< class pin >
+   struct cached< 
+      pin, 
+      typename pin::has_pin_oc 
+   > :
+      public pin_oc_archetype 
    {
-      typedef typename port::value_type value_type;
-   
-      static void init(){
-         port::init();
-         port::set( all_ones< value_type >::value );
-      }   
+      typedef _cached_shadow< cached, bool > shadow;
       
-      static value_type get(){ return port::get(); }
+      static void init(){ 
+         pin::init(); 
+         shadow::clear();
+      }
+      
+      static bool get(){ return pin::get(); }
+      
+      static void set( bool x ){
+         if( shadow::update( x )){
+            pin::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            pin::set( shadow::value );
+         }
+      }
+   };
+   
+   
+   // =======================================================================
+   //
+   // traced
+   //
+   // Count the set(), get() and direction calls on a pin (or port), 
+   // to see how many I/O operations a driver performs. When a 
+   // trace_recorder is specified each set() and get() also appends 
+   // a (moment, signal, level) event to its buffer, which can be 
+   // written as a VCD file for a waveform viewer like GTKWave.
+   //
+   //    typedef trace_recorder< timing > recorder;
+   //    typedef traced< target::pin_out< 0, 4 >, recorder > sclk;
+   //    ...
+   //    sclk::init( "sclk" );
+   //    ...
+   //    recorder::vcd( std::cout );
+   //
+   // The first init() registers the signal, later init() calls (for
+   // instance by a driver that uses the traced pin) only clear the
+   // counters.
+   //
+   // =======================================================================
+   
+   // a buffer of the events of the traced<> pins and ports
+   template< class timing, unsigned int n = 1024 >
+   struct trace_recorder {
+   
+      static constexpr unsigned int max_signals = 32;
+   
+      struct event {
+         typename timing::moment time;
+         unsigned int signal;
+         unsigned int value;
+      };
+      
+      static event events[ n ];
+      static unsigned int n_events;
+      
+      // the number of events that were dropped because the buffer was full
+      static unsigned int overflows;
+      
+      static const char * names[ max_signals ];
+      static unsigned int widths[ max_signals ];
+      static unsigned int n_signals;
+      
+      // register a signal, return its number
+      static unsigned int add( const char * name, unsigned int width ){
+         if( n_signals == max_signals ){
+            return max_signals;
+         }
+         names[ n_signals ] = name;
+         widths[ n_signals ] = width;
+         return n_signals++;
+      }
+      
+      static void rename( unsigned int signal, const char * name ){
+         if( signal < n_signals ){
+            names[ signal ] = name;
+         }
+      }
+      
+      static void record( unsigned int signal, unsigned int value ){
+         if( signal >= n_signals ){
+            return;
+         }
+         if( n_events == n ){
+            overflows++;
+            return;
+         }
+         events[ n_events ].time = timing::now();
+         events[ n_events ].signal = signal;
+         events[ n_events ].value = value;
+         n_events++;
+      }
+      
+      // forget the events, but keep the signals
+      static void clear(){
+         n_events = 0;
+         overflows = 0;
+      }
+      
+      // write the events as a VCD file, times relative to the first event
+      template< class stream >
+      static void vcd( stream & out ){
+         out << "$timescale 1ns $end\n";
+         out << "$scope module hwcpp $end\n";
+         for( unsigned int i = 0; i < n_signals; i++ ){
+            out 
+               << "$var wire " << widths[ i ] 
+               << " " << (char)( '!' + i ) 
+               << " " << names[ i ] << " $end\n";
+         }
+         out << "$upscope $end\n";
+         out << "$enddefinitions $end\n";
+         for( unsigned int i = 0; i < n_events; i++ ){
+            const event & e = events[ i ];
+            if(( i == 0 ) || ( e.time != events[ i - 1 ].time )){
+               long long int t = ( e.time - events[ 0 ].time ).raw();
+               out << "#" << t * 1000 / timing::duration::ticks_per_us << "\n";
+            }
+            if( widths[ e.signal ] == 1 ){
+               out << (char)( '0' + ( e.value & 0x01 ));
+            } else {
+               out << "b";
+               for( unsigned int b = widths[ e.signal ]; b > 0; b-- ){
+                  out << (char)( '0' + (( e.value >> ( b - 1 )) & 0x01 ));
+               }
+               out << " ";
+            }
+            out << (char)( '!' + e.signal ) << "\n";
+         }
+      }
+   };
+   
+   template< class t, unsigned int n >
+      typename trace_recorder< t, n >::event 
+         trace_recorder< t, n >::events[ n ];
+   template< class t, unsigned int n >
+      unsigned int trace_recorder< t, n >::n_events;
+   template< class t, unsigned int n >
+      unsigned int trace_recorder< t, n >::overflows;
+   template< class t, unsigned int n >
+      const char * trace_recorder< t, n >::names[ max_signals ];
+   template< class t, unsigned int n >
+      unsigned int trace_recorder< t, n >::widths[ max_signals ];
+   template< class t, unsigned int n >
+      unsigned int trace_recorder< t, n >::n_signals;
+   
+   // the recorder of a traced<>, or none
+   template< class recorder >
+   struct _trace_signal {
+      static unsigned int add( const char * name, unsigned int width ){
+         return recorder::add( name, width );
+      }
+      static void rename( unsigned int signal, const char * name ){
+         recorder::rename( signal, name );
+      }
+      static void record( unsigned int signal, unsigned int value ){
+         recorder::record( signal, value );
+      }
+   };
+   
+   template<>
+   struct _trace_signal< void > {
+      static unsigned int add( const char * name, unsigned int width ){
+         return 0;
+      }
+      static void rename( unsigned int signal, const char * name ){}
+      static void record( unsigned int signal, unsigned int value ){}
+   };
+   
+   // the counters of a traced<> pin or port
+   template< class t, class recorder, unsigned int width >
+   struct _traced_counters {
+      static unsigned int n_set;
+      static unsigned int n_get;
+      static unsigned int n_direction;
+      
+      static void counters_clear(){
+         n_set = 0;
+         n_get = 0;
+         n_direction = 0;
+      }
+      
+   protected:
+   
+      static unsigned int signal;
+      static bool registered;
+      
+      // add the signal at the first init() only (a driver may call
+      // init() again), a name passed to a later init() renames it
+      static void trace_init( const char * name, const char * fallback ){
+         if( ! registered ){
+            signal = _trace_signal< recorder >::add( 
+               ( name != nullptr ) ? name : fallback, width );
+            registered = true;
+         } else if( name != nullptr ){
+            _trace_signal< recorder >::rename( signal, name );
+         }
+         counters_clear();
+      }
+      
+      static void trace_set( unsigned int x ){
+         n_set++;
+         _trace_signal< recorder >::record( signal, x );
+      }
+      
+      static unsigned int trace_get( unsigned int x ){
+         n_get++;
+         _trace_signal< recorder >::record( signal, x );
+         return x;
+      }
+   };
+   
+   template< class t, class r, unsigned int w >
+      unsigned int _traced_counters< t, r, w >::n_set;
+   template< class t, class r, unsigned int w >
+      unsigned int _traced_counters< t, r, w >::n_get;
+   template< class t, class r, unsigned int w >
+      unsigned int _traced_counters< t, r, w >::n_direction;
+   template< class t, class r, unsigned int w >
+      unsigned int _traced_counters< t, r, w >::signal;
+   template< class t, class r, unsigned int w >
+      bool _traced_counters< t, r, w >::registered;
+   
+   // fallback: compiler error
+   template< 
+      class unsupported, 
+      class recorder = void,
+      class dummy = void 
+   > struct traced {
+      static_assert( 
+         sizeof( unsupported ) == 0, 
+         "traced<> requires a pin_in, pin_out, pin_in_out, pin_oc, "
+         "or a corresponding port" 
+      );
+   };
+   
+   // from a pin_in: count and trace get()
+   template< class pin, class recorder >
+   struct traced< pin, recorder, typename pin::has_pin_in > :
+      public pin_in_archetype,
+      public _traced_counters< pin, recorder, 1 >
+   {
+      typedef _traced_counters< pin, recorder, 1 > counters;
+      
+      static void init( const char * name = nullptr ){ 
+         pin::init(); 
+         counters::trace_init( name, "pin" );
+      }
+      
+      static bool get(){ return counters::trace_get( pin::get() ); }
+   };
+   
+   // from a pin_out: count and trace set()
+   template< class pin, class recorder >
+   struct traced< pin, recorder, typename pin::has_pin_out > :
+      public pin_out_archetype,
+      public _traced_counters< pin, recorder, 1 >
+   {
+      typedef _traced_counters< pin, recorder, 1 > counters;
+      
+      static void init( const char * name = nullptr ){ 
+         pin::init(); 
+         counters::trace_init( name, "pin" );
+      }
+      
+      static void set( bool x ){ 
+         counters::trace_set( x ); 
+         pin::set( x ); 
+      }
+   };
+   
+   // from a pin_in_out: count the direction calls, count and trace 
+   // set() and get()
+   template< class pin, class recorder >
+   struct traced< pin, recorder, typename pin::has_pin_in_out > :
+      public pin_in_out_archetype,
+      public _traced_counters< pin, recorder, 1 >
+   {
+      typedef _traced_counters< pin, recorder, 1 > counters;
+      
+      static void init( const char * name = nullptr ){ 
+         pin::init(); 
+         counters::trace_init( name, "pin" );
+      }
+      
+      static void direction_set_input(){ 
+         counters::n_direction++;
+         pin::direction_set_input(); 
+      }
+      
+      static void direction_set_output(){ 
+         counters::n_direction++;
+         pin::direction_set_output(); 
+      }
+      
+      static void set( bool x ){ 
+         counters::trace_set( x ); 
+         pin::set( x ); 
+      }
+      
+      static bool get(){ return counters::trace_get( pin::get() ); }
+   };
+   
+   // from a pin_oc: count and trace set() and get()
+   template< class pin, class recorder >
+   struct traced< pin, recorder, typename pin::has_pin_oc > :
+      public pin_oc_archetype,
+      public _traced_counters< pin, recorder, 1 >
+   {
+      typedef _traced_counters< pin, recorder, 1 > counters;
+      
+      static void init( const char * name = nullptr ){ 
+         pin::init(); 
+         counters::trace_init( name, "pin" );
+      }
+      
+      static void set( bool x ){ 
+         counters::trace_set( x ); 
+         pin::set( x ); 
+      }
+      
+      static bool get(){ return counters::trace_get( pin::get() ); }
+   };
+   
+   
+   // =======================================================================
+   //
+   // Blinking
+   //
+   // =======================================================================
+   
+   template< typename arg_timing >
+   struct waiting_from : public arg_timing {
+      
+      
+   };
+     
+   template< 
+      typename arg_pin, 
+      typename timing
+   > struct blink { 
+     
+      typedef pin_out_from< arg_pin > pin;
+      // typedef waiting_from< arg_timing > timing;
+      
+      typedef typename timing::duration duration;
+        
+      static void run( const duration t = duration::ms( 500 )){    
+         timing::init();
+         pin::init(); 
+         for(;;){
+            pin::set( 1 );
+            timing::wait( t / 2 );
+            pin::set( 0 );
+            timing::wait( t / 2 );
+         }
+      }
+   };
+   
+
+   // =======================================================================
+   //
+   // ...
+   //
+   // =======================================================================
+     
+   // used to select a pin from a port
+   template< class port, unsigned int n > 
+      struct _pin_select : public _pin_select< 
+         typename port::tail, n - 1 > {};
+   template< class port >
+      struct _pin_select< port, 0 > : public port::_pin {};   
+      
+   // the maximum value (all bits 1) of an unsigned integer
+   template< class t, int n > 
+      struct _all_ones { 
+         static constexpr t value = 
+            ( _all_ones< t, n - 1 >::value << 8 ) | 0xFF; };
+   template< class t > 
+      struct _all_ones< t, 0 > {
+         static constexpr t value = 0x00; };
+   template< class t >
+      struct all_ones : public _all_ones< t, sizeof( t ) >{};
+
+
+   // =======================================================================
+   //
+   // port register grouping
+   //
+   // Used by the port_xxx_from_pins adapters to write (read) the pins 
+   // that share a port register with a single set_masked() (get()) 
+   // call per register instead of a set() (get()) call per pin.
+   //
+   // The value bits are moved to and from the register bits in runs:
+   // all pins of a register for which the register bit is the same
+   // distance d above the value bit are moved by one shift over d 
+   // and one mask. For pins that are wired in order this is a single 
+   // shift-and-mask per register.
+   //
+   // When the pins of a register are wired so haphazardly that this 
+   // needs more than HWCPP_PORT_MAX_RUNS runs per byte, the bits are
+   // instead moved by a 256-entry lookup table per value byte (for 
+   // a write) or register byte (for a read). Those tables are 
+   // computed by the compiler and cost 1 Kb of ROM each, so define
+   // HWCPP_PORT_MAX_RUNS as a large value to never use them.
+   //
+   // =======================================================================
+
+   // a list of pins, used to pass all pins of a port as one parameter
+   template< class... pins > struct _pin_list {};
+
+   // inherit this to pass the pin list of a port made from pins
+   // on to a port that delegates set() unmodified
+   template< class port, class dummy = void >
+   struct pin_list_forward {};
+
+   template< class port >
+   struct pin_list_forward< port, typename port::has_pin_list > {
+      typedef void has_pin_list;
+      typedef typename port::pin_list pin_list;
+   };
+
+   // a port that is used as one (n_pins wide) element of a pin list
+   template< class port > struct _port_element {};
+
+   // the number of value bits used by an element of a pin list
+   template< class pin > struct _pin_width {
+      static constexpr int value = 1;
+   };
+
+   template< class port > struct _pin_width< _port_element< port >> {
+      static constexpr int value = port::n_pins;
+   };
+
+   // x shifted left over d bits, or right over -d bits when d < 0
+   constexpr unsigned int _shift( unsigned int x, int d ){
+      return ( d >= 0 ) ? ( x << d ) : ( x >> -d );
+   }
+
+   // is reg the port register of one of the pins?
+   template< class reg, class... pins >
+   struct _register_used {
+      static constexpr bool value = false;
+   };
+
+   template< class reg, class pin, class... tail >
+   struct _register_used< reg, pin, tail... > {
+      static constexpr bool value =
+         same_type<
+            reg,
+            typename port_register_of< pin >::port_register
+         >::value
+         || _register_used< reg, tail... >::value;
+   };
+
+   // the run of pins in reg for which register bit == value bit + d,
+   // the first pin is value bit n
+   template< class reg, int d, int n, class... pins >
+   struct _register_run {
+      static constexpr unsigned int value_mask = 0;
+      static constexpr unsigned int register_mask = 0;
+   };
+
+   template< class reg, int d, int n, class pin, class... tail >
+   struct _register_run< reg, d, n, pin, tail... > {
+      typedef port_register_of< pin > info;
+      typedef _register_run< reg, d, n + _pin_width< pin >::value, tail... > 
+         next;
+      static constexpr bool in_run =
+         same_type< reg, typename info::port_register >::value
+         && ( info::bit - n == d );
+
+      static constexpr unsigned int value_mask =
+         ( in_run ? ( 0x01U << n ) : 0 ) | next::value_mask;
+      static constexpr unsigned int register_mask =
+         ( in_run ? ( 0x01U << info::bit ) : 0 ) | next::register_mask;
+   };
+
+   // the shift/mask table between the value and the pins in reg: 
+   // one shift-and-mask for each run, generated at the last pin 
+   // of that run (all are all pins, rest are the pins from value 
+   // bit n onwards)
+   template< class reg, class all, int n, class... rest >
+   struct _register_map {
+      static constexpr unsigned int mask = 0;
+      static constexpr unsigned int value_mask = 0;
+      static constexpr int runs = 0;
+      static constexpr unsigned int scatter( unsigned int x ){ return 0; }
+      static constexpr unsigned int gather( unsigned int r ){ return 0; }
+   };
+
+   template< class reg, class... all, int n, class pin, class... tail >
+   struct _register_map< reg, _pin_list< all... >, n, pin, tail... > {
+      typedef port_register_of< pin > info;
+      typedef _register_map< 
+         reg, _pin_list< all... >, n + _pin_width< pin >::value, tail... 
+      > next;
+      static constexpr int d = info::bit - n;
+      typedef _register_run< reg, d, 0, all... > run;
+
+      static constexpr bool in_reg =
+         same_type< reg, typename info::port_register >::value;
+      static constexpr bool last_of_run = in_reg 
+         && ( _register_run< 
+            reg, d, n + _pin_width< pin >::value, tail... 
+         >::value_mask == 0 );
+
+      static constexpr unsigned int mask =
+         ( in_reg ? ( 0x01U << info::bit ) : 0 ) | next::mask;
+      static constexpr unsigned int value_mask =
+         ( in_reg ? ( 0x01U << n ) : 0 ) | next::value_mask;
+      static constexpr int runs = 
+         ( last_of_run ? 1 : 0 ) + next::runs;
+
+      static constexpr unsigned int scatter( unsigned int x ){
+         return ( last_of_run ? _shift( x & run::value_mask, d ) : 0 )
+            | next::scatter( x );
+      }
+
+      static constexpr unsigned int gather( unsigned int r ){
+         return ( last_of_run ? _shift( r & run::register_mask, -d ) : 0 )
+            | next::gather( r );
+      }
+   };
+
+   #ifndef HWCPP_PORT_MAX_RUNS
+      #define HWCPP_PORT_MAX_RUNS 3
+   #endif
+
+   // the number of bytes in which mask has a 1 bit
+   constexpr int _bytes_used( unsigned int mask ){
+      return ( mask == 0 ) 
+         ? 0 
+         : (( mask & 0xFF ) != 0 ) + _bytes_used( mask >> 8 );
+   }
+
+   // a list of indexes 0 .. n - 1
+   template< int... i > struct _index_list {};
+
+   template< class list > struct _index_double;
+
+   template< int... i > struct _index_double< _index_list< i... >> {
+      typedef _index_list< i..., ( i + sizeof...( i ))... > type;
+   };
+
+   template< int n > struct _index_range {
+      typedef typename _index_double< 
+         typename _index_range< n / 2 >::type >::type type;
+   };
+
+   template<> struct _index_range< 1 > {
+      typedef _index_list< 0 > type;
+   };
+
+   // lookup tables for one byte of the value (scatter) 
+   // or of the register (gather)
+   template< class map, int byte, class list = _index_range< 256 >::type >
+   struct _register_lut;
+
+   template< class map, int byte, int... i >
+   struct _register_lut< map, byte, _index_list< i... >> {
+      static constexpr unsigned int scatter_table[ 256 ] = {
+         map::scatter( (unsigned int) i << ( 8 * byte ))...
+      };
+      static constexpr unsigned int gather_table[ 256 ] = {
+         map::gather( (unsigned int) i << ( 8 * byte ))...
+      };
+   };
+
+   template< class map, int byte, int... i >
+   constexpr unsigned int 
+      _register_lut< map, byte, _index_list< i... >>::scatter_table[ 256 ];
+
+   template< class map, int byte, int... i >
+   constexpr unsigned int 
+      _register_lut< map, byte, _index_list< i... >>::gather_table[ 256 ];
+
+   // scatter (gather) one byte when it is used by the map
+   template< class map, int byte, bool used >
+   struct _register_lut_byte {
+      static unsigned int scatter( unsigned int x ){ return 0; }
+      static unsigned int gather( unsigned int r ){ return 0; }
+   };
+
+   template< class map, int byte >
+   struct _register_lut_byte< map, byte, true > {
+      typedef _register_lut< map, byte > lut;
+      static unsigned int scatter( unsigned int x ){
+         return lut::scatter_table[ ( x >> ( 8 * byte )) & 0xFF ];
+      }
+      static unsigned int gather( unsigned int r ){
+         return lut::gather_table[ ( r >> ( 8 * byte )) & 0xFF ];
+      }
+   };
+
+   // the map between the value and the pins in reg: 
+   // the shift-and-mask runs, or lookup tables when those are 
+   // too fragmented
+   template< class map, bool use_lut >
+   struct _register_access : public map {};
+
+   template< class map >
+   struct _register_access< map, true > {
+      static constexpr unsigned int mask = map::mask;
+
+      template< int byte > struct value_byte : 
+         public _register_lut_byte< map, byte,
+            (( map::value_mask >> ( 8 * byte )) & 0xFF ) != 0 > {};
+
+      template< int byte > struct register_byte : 
+         public _register_lut_byte< map, byte,
+            (( map::mask >> ( 8 * byte )) & 0xFF ) != 0 > {};
+
+      static unsigned int scatter( unsigned int x ){
+         return value_byte< 0 >::scatter( x ) 
+            | value_byte< 1 >::scatter( x )
+            | value_byte< 2 >::scatter( x ) 
+            | value_byte< 3 >::scatter( x );
+      }
+
+      static unsigned int gather( unsigned int r ){
+         return register_byte< 0 >::gather( r ) 
+            | register_byte< 1 >::gather( r )
+            | register_byte< 2 >::gather( r ) 
+            | register_byte< 3 >::gather( r );
+      }
+   };
+
+   template< class reg, class all > struct _register_table;
+
+   template< class reg, class... pins >
+   struct _register_table< reg, _pin_list< pins... >> {
+      typedef _register_map< reg, _pin_list< pins... >, 0, pins... > map;
+      typedef _register_access< 
+         map, 
+         ( map::runs 
+            > HWCPP_PORT_MAX_RUNS * _bytes_used( map::value_mask ))
+      > type;
+   };
+
+   // for value bit n: access the pin, or, at the last pin of
+   // a port register, access all pins in that register
+   template< bool known, bool last, class pin, class all >
+   struct _port_group_access;
+
+   template< class pin, class all >
+   struct _port_group_access< false, false, pin, all > {
+      static void set( unsigned int x, int n ){
+         pin_out_from< pin >::set(( x >> n ) & 0x01 );
+      }
+      static unsigned int get( int n ){
+         return ( pin_in_from< pin >::get() ? 0x01U : 0x00U ) << n;
+      }
+   };
+
+   template< class pin, class all >
+   struct _port_group_access< true, false, pin, all > {
+      static void set( unsigned int x, int n ){}
+      static unsigned int get( int n ){ return 0; }
+   };
+
+   template< class pin, class... pins >
+   struct _port_group_access< true, true, pin, _pin_list< pins... >> {
+      typedef typename port_register_of< pin >::port_register reg;
+      typedef typename _register_table< 
+         reg, _pin_list< pins... > >::type table;
+      static void set( unsigned int x, int n ){
+         reg::set_masked( table::mask, table::scatter( x ));
+      }
+      static unsigned int get( int n ){
+         return table::gather( reg::get() );
+      }
+   };
+
+   // write x to or read the value from the pins in rest, 
+   // which are the last pins of all, starting at value bit n
+   template< class all, int n, class... rest >
+   struct _port_grouped {
+      static void set( unsigned int x ){}
+      static unsigned int get(){ return 0; }
+   };
+
+   template< class all, int n, class pin, class... tail >
+   struct _port_grouped< all, n, pin, tail... > {
+      typedef port_register_of< pin > info;
+      typedef _port_group_access<
+         info::known,
+         info::known
+            && ! _register_used<
+               typename info::port_register, tail... >::value,
+         pin,
+         all
+      > access;
+      typedef _port_grouped< all, n + 1, tail... > next;
+      
+      static void set( unsigned int x ){
+         access::set( x, n );
+         next::set( x );
+      }
+      
+      static unsigned int get(){
+         return access::get( n ) | next::get();
+      }
+   };
+
+
+   // =======================================================================
+   //
+   // port_in_from
+   //
+   // =======================================================================
+   
+   // fallback: compile-time error
+   template< 
+      class unsupported, 
+      class dummy = void 
+   > 
+   struct port_in_from {
+      static_assert( 
+         sizeof( unsupported ) == 0, 
+         "port_in_from<> requires "
+         "a port_in, port_in_out, or port_oc" 
+      );
+   };
+   
+   // from itself: delegate
+   template< class port >
+   struct port_in_from < 
+      port, 
+      typename port::has_port_in 
+   > 
+   : public 
+      port_in< port::n_pins >
+   {
+      typedef typename port::value_type value_type;
+      static void init(){ port::init(); }
+      static value_type get(){ return port::get(); }    
+   };
+   
+   // from a port_in_out: init sets the direction to input
+   template< class port >
+   struct port_in_from <  
+      port, 
+      typename port::has_port_in_out
+   > 
+   : public 
+      port_in< port::n_pins > 
+   {
+      typedef typename port::value_type value_type;
+   
+      static void init(){
+         port::init();
+         port::direction_set_input();
+      }   
+      
+      static value_type get(){ return port::get(); }
+   };
+   
+   // from a port_oc: init sets the pins high
+   template< class port >
+   struct port_in_from <  
+      port, 
+      typename port::has_port_oc
+   >  
+   : public 
+      port_in< port::n_pins > 
+   {
+      typedef typename port::value_type value_type;
+   
+      static void init(){
+         port::init();
+         port::set( all_ones< value_type >::value );
+      }   
+      
+      static value_type get(){ return port::get(); }
    };
    
    
@@ -883,7 +1907,8 @@ namespace hwcpp {
       typename port::has_port_out 
    > 
    : public 
-      port_out< port::n_pins >
+      port_out< port::n_pins >,
+      pin_list_forward< port >
    {
       typedef typename port::value_type value_type;   
       static void init(){ port::init(); }
@@ -896,7 +1921,8 @@ namespace hwcpp {
       port, 
       typename port::has_port_in_out
    > : public 
-      port_out< port::n_pins > 
+      port_out< port::n_pins >,
+      pin_list_forward< port >
    {
       typedef typename port::value_type value_type;
       
@@ -1084,8 +2110,11 @@ namespace hwcpp {
          tail::init(); 
       }
       
+      typedef _pin_list< arg_pin, tail_args... > pin_list;
+      
+      // pins that share a port register are read together
       static unsigned int get(){
-         return ( _pin::get() ? 0x01 : 0x00 ) | ( tail::get() << 1 );
+         return _port_grouped< pin_list, 0, arg_pin, tail_args... >::get();
       }
    
    };
@@ -1151,9 +2180,12 @@ namespace hwcpp {
          tail::init(); 
       }
       
+      typedef void has_pin_list;
+      typedef _pin_list< arg_pin, tail_args... > pin_list;
+      
+      // pins that share a port register are written together
       static void set( unsigned int x ){
-         _pin::set( x & 0x01 );
-         tail::set( x >> 1 );
+         _port_grouped< pin_list, 0, arg_pin, tail_args... >::set( x );
       }
       
    };
@@ -1230,15 +2262,262 @@ namespace hwcpp {
          tail::direction_set_output();
       }
       
+      typedef void has_pin_list;
+      typedef _pin_list< arg_pin, tail_args... > pin_list;
+      
+      // pins that share a port register are written together
       static void set( unsigned int x ){
-         _pin::set( x & 0x01 );
-         tail::set( x >> 1 );
+         _port_grouped< pin_list, 0, arg_pin, tail_args... >::set( x );
       }
       
+      // pins that share a port register are read together
       static unsigned int get(){
-         return ( _pin::get() ? 0x01 : 0x00 ) | ( tail::get() << 1 );
+         return _port_grouped< pin_list, 0, arg_pin, tail_args... >::get();
+      }
+   
+   };
+   
+   
+   // =======================================================================
+   //
+   // port_transaction
+   //
+   // A port_transaction object collects set() calls on a number of 
+   // items (pins, or ports) in a shadow value, and writes them when it
+   // is committed: by commit(), or when the object goes out of scope.
+   // Pins that share a port register (also the pins of a port made
+   // with port_out_from_pins or port_in_out_from_pins) are written 
+   // with one set_masked() call per register, so they change at 
+   // the same moment. Other pins are written one by one, and other
+   // ports are written as a whole, in the order of the items.
+   //
+   // Only the bits that were set() since the last commit are written.
+   //
+   //    {
+   //       port_transaction< rs, data > t;
+   //       t.template set< rs >( 1 );
+   //       t.template set< data >( 0x0A );
+   //    } // rs and data are written here
+   //
+   // =======================================================================
+   
+   // concatenate two pin lists
+   template< class a, class b > struct _pin_list_cat;
+   
+   template< class... a, class... b >
+   struct _pin_list_cat< _pin_list< a... >, _pin_list< b... >> {
+      typedef _pin_list< a..., b... > type;
+   };
+   
+   // the elements (pins, or ports that are used as a whole) of an item
+   template< class item, class dummy = void > 
+   struct _transaction_port {
+      typedef _pin_list< _port_element< item >> elements;
+   };
+   
+   template< class item > 
+   struct _transaction_port< item, typename item::has_pin_list > {
+      typedef typename item::pin_list elements;
+   };
+   
+   template< class item, class dummy = void > 
+   struct _transaction_item {
+      typedef _pin_list< item > elements;
+      static constexpr int width = 1;
+   };
+   
+   template< class item > 
+   struct _transaction_item< item, typename item::has_port_out > :
+      public _transaction_port< item >
+   {
+      static constexpr int width = item::n_pins;
+   };
+   
+   template< class item > 
+   struct _transaction_item< item, typename item::has_port_in_out > :
+      public _transaction_port< item >
+   {
+      static constexpr int width = item::n_pins;
+   };
+   
+   template< class item > 
+   struct _transaction_item< item, typename item::has_port_oc > :
+      public _transaction_port< item >
+   {
+      static constexpr int width = item::n_pins;
+   };
+   
+   // all elements of the items
+   template< class... items > 
+   struct _transaction_elements {
+      typedef _pin_list<> type;
+      static constexpr int width = 0;
+   };
+   
+   template< class item, class... tail > 
+   struct _transaction_elements< item, tail... > {
+      typedef typename _pin_list_cat<
+         typename _transaction_item< item >::elements,
+         typename _transaction_elements< tail... >::type
+      >::type type;
+      static constexpr int width = 
+         _transaction_item< item >::width
+         + _transaction_elements< tail... >::width;
+   };
+   
+   // the first value bit of an item
+   template< class item, int n, class... items >
+   struct _transaction_offset {
+      static_assert( 
+         sizeof( item ) == 0, 
+         "port_transaction::set<> requires one of its items" 
+      );
+   };
+   
+   template< class item, int n, class... tail >
+   struct _transaction_offset< item, n, item, tail... > {
+      static constexpr int value = n;
+   };
+   
+   template< class item, int n, class other, class... tail >
+   struct _transaction_offset< item, n, other, tail... > :
+      public _transaction_offset< 
+         item, n + _transaction_item< other >::width, tail... 
+      >
+   {};
+   
+   // n value bits, all 1
+   constexpr unsigned int _low_ones( int n ){
+      return ( n >= 32 ) ? ~ 0U : (( 0x01U << n ) - 1 );
+   }
+   
+   // write the dirty bits of element e, which is at value bit n,
+   // or, at the last pin of a port register, of all pins in that register
+   template< bool known, bool last, class e, class all >
+   struct _transaction_write {
+      static void commit( unsigned int value, unsigned int dirty, int n ){
+         if(( dirty >> n ) & 0x01 ){
+            pin_out_from< e >::set(( value >> n ) & 0x01 );
+         }
+      }
+   };
+   
+   template< class port, class all >
+   struct _transaction_write< false, false, _port_element< port >, all > {
+      static constexpr unsigned int mask = _low_ones( port::n_pins );
+      static void commit( unsigned int value, unsigned int dirty, int n ){
+         if(( dirty >> n ) & mask ){
+            port_out_from< port >::set(( value >> n ) & mask );
+         }
+      }
+   };
+   
+   template< class e, class all >
+   struct _transaction_write< true, false, e, all > {
+      static void commit( unsigned int value, unsigned int dirty, int n ){}
+   };
+   
+   template< class e, class... elements >
+   struct _transaction_write< true, true, e, _pin_list< elements... >> {
+      typedef typename port_register_of< e >::port_register reg;
+      typedef typename _register_table< 
+         reg, _pin_list< elements... > >::type table;
+      static void commit( unsigned int value, unsigned int dirty, int n ){
+         unsigned int mask = table::scatter( dirty );
+         if( mask != 0 ){
+            reg::set_masked( mask, table::scatter( value ));
+         }
+      }
+   };
+   
+   template< class all, int n, class... rest >
+   struct _transaction_commit {
+      static void commit( unsigned int value, unsigned int dirty ){}
+   };
+   
+   template< class all, int n, class e, class... tail >
+   struct _transaction_commit< all, n, e, tail... > {
+      typedef port_register_of< e > info;
+      static void commit( unsigned int value, unsigned int dirty ){
+         _transaction_write<
+            info::known,
+            info::known
+               && ! _register_used<
+                  typename info::port_register, tail... >::value,
+            e,
+            all
+         >::commit( value, dirty, n );
+         _transaction_commit< all, n + _pin_width< e >::value, tail... >
+            ::commit( value, dirty );
       }
+   };
+   
+   template< class all > struct _transaction_all;
+   
+   template< class... elements > 
+   struct _transaction_all< _pin_list< elements... >> {
+      typedef _transaction_commit< 
+         _pin_list< elements... >, 0, elements... 
+      > writer;
+   };
+   
+   template< typename... items >
+   class port_transaction : 
+      public noncopyable 
+   {
+   public:
+   
+      // the value bits: the items in order, the lowest at bit 0
+      static constexpr int n_pins = _transaction_elements< items... >::width;
+      
+      static_assert( 
+         n_pins <= 32, 
+         "port_transaction<> supports at most 32 pins" 
+      );
+
+   private:
+   
+      typedef typename _transaction_elements< items... >::type elements;
+      
+      unsigned int value;
+      unsigned int dirty;
+      
+   public:
    
+      port_transaction(): value( 0 ), dirty( 0 ){}
+      
+      ~port_transaction(){
+         commit();
+      }
+      
+      // set the bits of the value that are 1 in mask 
+      void set( unsigned int x, unsigned int mask = _low_ones( n_pins )){
+         value = ( value & ~ mask ) | ( x & mask );
+         dirty |= mask;
+      }
+      
+      // set the value of one item
+      template< class item >
+      void set( unsigned int x ){
+         set(
+            x << _transaction_offset< item, 0, items... >::value,
+            _low_ones( _transaction_item< item >::width )
+               << _transaction_offset< item, 0, items... >::value
+         );
+      }
+      
+      // write the bits that were set, with as few writes as possible
+      void commit(){
+         if( dirty != 0 ){
+            _transaction_all< elements >::writer::commit( value, dirty );
+            dirty = 0;
+         }
+      }
+      
+      // forget the bits that were set since the last commit
+      void cancel(){
+         dirty = 0;
+      }
    };
    
    
@@ -1389,6 +2668,180 @@ namespace hwcpp {
       
    };	
    
+   // =======================================================================
+   //
+   // debounce
+   //
+   // =======================================================================
+   
+   // in pins.hpp:
+   // fallback: compiler error
+   // template< 
+   //    class unsupported, 
+   //    class timing,
+   //    class interval = typename timing::template ms< 5 >,
+   //    unsigned int stable = 4,
+   //    class dummy = void 
+   // > struct debounce { . . . }; 
+   
+   // from a port_in: a vertical counter, sampled by a clock callback
+   template< 
+      class port, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      port, 
+      timing, 
+      interval, 
+      stable, 
+      typename port::has_port_in 
+   > :
+      public port_in_archetype< port::n_pins > 
+   {
+      static_assert( 
+         ( stable >= 1 ) && ( stable < 256 ), 
+         "debounce<> stable must be 1..255" 
+      );
+   
+      typedef typename port::value_type value_type;
+      static constexpr int counter_bits = _bits_needed( stable );
+      
+   private:
+   
+      static value_type state;
+      static value_type count[ counter_bits ];
+      static value_type rising;
+      static value_type falling;
+      
+      struct sampler : 
+         public timing::template clock< interval >
+      {
+         void function() override {
+            sample();
+         }
+      };
+      
+   public:
+   
+      static void init(){
+         timing::init();
+         port::init();
+         state = port::get();
+         for( int i = 0; i < counter_bits; i++ ){
+            count[ i ] = 0;
+         }
+         rising = 0;
+         falling = 0;
+         static sampler instance;
+      }
+      
+      static value_type get(){
+         return state;
+      }
+      
+      // the bits that went high since the previous call
+      static value_type pressed(){
+         value_type result = rising;
+         rising = 0;
+         return result;
+      }
+      
+      // the bits that went low since the previous call
+      static value_type released(){
+         value_type result = falling;
+         falling = 0;
+         return result;
+      }
+      
+      // process one sample of the input
+      static void filter( value_type x ){
+         value_type differ = x ^ state;
+         
+         // increment the count of the bits that differ, 
+         // restart the other bits
+         value_type carry = differ;
+         for( int i = 0; i < counter_bits; i++ ){
+            value_type c = count[ i ];
+            count[ i ] = ( c ^ carry ) & differ;
+            carry = c & carry;
+         }
+         
+         // the bits that have now differed for stable samples
+         value_type done = differ;
+         for( int i = 0; i < counter_bits; i++ ){
+            done &= (( stable >> i ) & 0x01 ) 
+               ? count[ i ] 
+               : (value_type) ~ count[ i ];
+         }
+         for( int i = 0; i < counter_bits; i++ ){
+            count[ i ] &= ~ done;
+         }
+         
+         state ^= done;
+         rising |= done & state;
+         falling |= done & ~ state;
+      }
+      
+      // sample the input (called by the clock callback)
+      static void sample(){
+         filter( port::get() );
+      }
+   };
+   
+   template< class p, class t, class i, unsigned int s >
+      typename debounce< p, t, i, s, typename p::has_port_in >::value_type
+         debounce< p, t, i, s, typename p::has_port_in >::state;
+   
+   template< class p, class t, class i, unsigned int s >
+      typename debounce< p, t, i, s, typename p::has_port_in >::value_type
+         debounce< p, t, i, s, typename p::has_port_in >::count[ 
+            debounce< p, t, i, s, typename p::has_port_in >::counter_bits ];
+   
+   template< class p, class t, class i, unsigned int s >
+      typename debounce< p, t, i, s, typename p::has_port_in >::value_type
+         debounce< p, t, i, s, typename p::has_port_in >::rising;
+   
+   template< class p, class t, class i, unsigned int s >
+      typename debounce< p, t, i, s, typename p::has_port_in >::value_type
+         debounce< p, t, i, s, typename p::has_port_in >::falling;
+   
+   // from a port_in_out: convert it to a port_in
+   template< 
+      class port, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      port, 
+      timing, 
+      interval, 
+      stable, 
+      typename port::has_port_in_out 
+   > :
+      public debounce< port_in_from< port >, timing, interval, stable >
+   {};
+   
+   // from a port_oc: convert it to a port_in
+   template< 
+      class port, 
+      class timing, 
+      class interval, 
+      unsigned int stable 
+   >
+   struct debounce< 
+      port, 
+      timing, 
+      interval, 
+      stable, 
+      typename port::has_port_oc 
+   > :
+      public debounce< port_in_from< port >, timing, interval, stable >
+   {};
+   
+   
    // =======================================================================
    //
    // rising_edge
@@ -1451,6 +2904,531 @@ namespace hwcpp {
    {};
     
    
+   // =======================================================================
+   //
+   // edge_capture
+   //
+   // =======================================================================
+   
+   // in pins.hpp:
+   // fallback: compiler error
+   // template< 
+   //    class unsupported, 
+   //    class timing,
+   //    unsigned int n = 32,
+   //    edge_mode mode = edge_mode::both,
+   //    class dummy = void 
+   // > struct edge_capture { . . . }; 
+   
+   // from a port_in: sample it into the ring buffer
+   template< 
+      class port, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< port, timing, n, mode, typename port::has_port_in > {
+   
+      typedef typename port::value_type value_type;
+      
+      struct event {
+         typename timing::moment time;
+         value_type value;
+         value_type edges;
+      };
+      
+      // the number of events that were dropped because the buffer was full
+      static unsigned int overflows;
+      
+   private:
+   
+      static spsc_ring< event, n > buffer;
+      static value_type last;
+      
+   public:
+   
+      static void init(){
+         timing::init();
+         port::init();
+         last = port::get();
+         buffer.clear();
+         overflows = 0;
+      }
+      
+      // read the input and store an event when it shows an edge
+      static void sample(){
+         value_type value = port::get();
+         value_type changed = value ^ last;
+         last = value;
+         
+         value_type edges = 
+              ( mode == edge_mode::rising )  ? ( changed & value ) 
+            : ( mode == edge_mode::falling ) ? ( changed & ~ value )
+            : changed;
+         if( edges == 0 ){
+            return;
+         }
+         
+         // fill in the event in place
+         event * e;
+         if( buffer.push_span( e ) == 0 ){
+            overflows++;
+            return;
+         }
+         e->time = timing::now();
+         e->value = value;
+         e->edges = edges;
+         buffer.push_commit( 1 );
+      }
+      
+      // the number of events in the buffer
+      static unsigned int available(){
+         return buffer.count();
+      }
+      
+      // remove the oldest event from the buffer, 
+      // return false when the buffer is empty
+      static bool get( event & e ){
+         return buffer.pop( e );
+      }
+   };
+   
+   template< class p, class t, unsigned int n, edge_mode m >
+      unsigned int 
+         edge_capture< p, t, n, m, typename p::has_port_in >::overflows;
+   
+   template< class p, class t, unsigned int n, edge_mode m >
+      spsc_ring< 
+         typename edge_capture< p, t, n, m, typename p::has_port_in >::event,
+         n
+      > edge_capture< p, t, n, m, typename p::has_port_in >::buffer;
+   
+   template< class p, class t, unsigned int n, edge_mode m >
+      typename edge_capture< p, t, n, m, typename p::has_port_in >::value_type
+         edge_capture< p, t, n, m, typename p::has_port_in >::last;
+   
+   // from a port_in_out: convert it to a port_in
+   template< 
+      class port, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< 
+      port, timing, n, mode, typename port::has_port_in_out 
+   > :
+      public edge_capture< port_in_from< port >, timing, n, mode >
+   {};
+   
+   // from a port_oc: convert it to a port_in
+   template< 
+      class port, 
+      class timing,
+      unsigned int n,
+      edge_mode mode
+   >
+   struct edge_capture< 
+      port, timing, n, mode, typename port::has_port_oc 
+   > :
+      public edge_capture< port_in_from< port >, timing, n, mode >
+   {};
+   
+   
+   // =======================================================================
+   //
+   // cached
+   //
+   // =======================================================================
+   
+   // in pins.hpp:
+   // fallback: compiler error
+   // template< 
+   //    class unsupported, 
+   //    class dummy = void 
+   // > struct cached { . . . }; 
+   
+   // from a port_out: skip a set() of the same value
+   template< class port >
+   struct cached< 
+      port, 
+      typename port::has_port_out 
+   > :
+      public port_out_archetype< port::n_pins >
+   {
+      typedef typename port::value_type value_type;
+      typedef _cached_shadow< cached, value_type > shadow;
+      
+      static void init(){ 
+         port::init(); 
+         shadow::clear();
+      }
+      
+      static void set( value_type x ){
+         if( shadow::update( x )){
+            port::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            port::set( shadow::value );
+         }
+      }
+   };
+   
+   // from a port_in_out: skip a set() of the same value
+   template< class port >
+   struct cached< 
+      port, 
+      typename port::has_port_in_out 
+   > :
+      public port_in_out_archetype< port::n_pins >
+   {
+      typedef typename port::value_type value_type;
+      typedef _cached_shadow< cached, value_type > shadow;
+      
+      static void init(){ 
+         port::init(); 
+         shadow::clear();
+      }
+      
+      static void direction_set_input(){ port::direction_set_input(); }
+      static void direction_set_output(){ port::direction_set_output(); }
+      static value_type get(){ return port::get(); }
+      
+      static void set( value_type x ){
+         if( shadow::update( x )){
+            port::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            port::set( shadow::value );
+         }
+      }
+   };
+   
+   // from a port_oc: skip a set() of the same value
+   template< class port >
+   struct cached< 
+      port, 
+      typename port::has_port_oc 
+   > :
+      public port_oc_archetype< port::n_pins >
+   {
+      typedef typename port::value_type value_type;
+      typedef _cached_shadow< cached, value_type > shadow;
+      
+      static void init(){ 
+         port::init(); 
+         shadow::clear();
+      }
+      
+      static value_type get(){ return port::get(); }
+      
+      static void set( value_type x ){
+         if( shadow::update( x )){
+            port::set( x );
+         }
+      }
+      
+      static void force_flush(){
+         if( shadow::valid ){
+            port::set( shadow::value );
+         }
+      }
+   };
+   
+   
+   // =======================================================================
+   //
+   // soft_pwm
+   //
+   // Software PWM on all pins of a port, using bit-angle modulation:
+   // a PWM frame consists of one period for each bit of the duty
+   // cycle, the period for bit k lasts 2^k ticks. At the start of 
+   // the period for bit k the port is written with bit k of the duty 
+   // cycle of each pin, so a frame takes bits port writes (one per 
+   // timer callback), independent of the number of pins.
+   //
+   // set() changes the duty cycle of one pin in the next frame, 
+   // which is shown from the start of a frame after commit() is 
+   // called.
+   //
+   // =======================================================================
+   
+   // fallback: compiler error
+   template< 
+      class unsupported, 
+      class timing,
+      unsigned int bits = 8,
+      class tick = typename timing::template us< 50 >,
+      class dummy = void 
+   > struct soft_pwm {
+      static_assert( 
+         sizeof( unsupported ) == 0, 
+         "soft_pwm<> requires a port_out, port_in_out, or port_oc" 
+      );
+   };
+   
+   // from a port_out: write one bit plane per period
+   template< 
+      class port, 
+      class timing,
+      unsigned int bits,
+      class tick
+   >
+   struct soft_pwm< port, timing, bits, tick, typename port::has_port_out > {
+   
+      static_assert( 
+         ( bits >= 1 ) && ( bits <= 16 ), 
+         "soft_pwm<> bits must be 1..16" 
+      );
+      
+      typedef typename port::value_type value_type;
+      typedef typename timing::duration duration;
+      typedef typename timing::moment moment;
+      
+      // the number of ticks in a PWM frame
+      static constexpr unsigned int period = ( 1U << bits ) - 1;
+      
+   private:
+   
+      // the bit planes of the current frame, and of the next frame
+      static value_type shown[ bits ];
+      static value_type next[ bits ];
+      static volatile bool pending;
+      
+      static unsigned int plane;
+      static moment epoch;
+      
+      struct ticker : 
+         public timing::template timer<>
+      {
+         void function() override {
+            if(( plane == 0 ) && pending ){
+               for( unsigned int i = 0; i < bits; i++ ){
+                  shown[ i ] = next[ i ];
+               }
+               pending = false;
+            }
+            port::set( shown[ plane ] );
+            epoch += duration::ns( tick::_duration ) * ( 1 << plane );
+            plane = ( plane + 1 == bits ) ? 0 : plane + 1;
+            this->start( epoch );
+         }
+      };
+      
+   public:
+   
+      static void init(){
+         timing::init();
+         port::init();
+         for( unsigned int i = 0; i < bits; i++ ){
+            shown[ i ] = 0;
+            next[ i ] = 0;
+         }
+         pending = false;
+         plane = 0;
+         epoch = timing::now();
+         static ticker instance;
+         instance.start( epoch );
+      }
+      
+      // set the duty cycle (0 .. period) of pin n in the next frame:
+      // only bit n of each plane is changed, a larger duty is
+      // clamped to period, and a call for a pin the port does
+      // not have is ignored
+      static void set( unsigned int n, unsigned int duty ){
+         if( n >= (unsigned int) port::n_pins ){
+            return;
+         }
+         if( duty > period ){
+            duty = period;
+         }
+         value_type mask = (value_type) 1 << n;
+         for( unsigned int i = 0; i < bits; i++ ){
+            next[ i ] = (( duty >> i ) & 0x01 ) 
+               ? ( next[ i ] | mask ) 
+               : ( next[ i ] & ~ mask );
+         }
+      }
+      
+      // show the next frame from the start of the next frame
+      static void commit(){
+         pending = true;
+      }
+   };
+   
+   template< class p, class t, unsigned int b, class k >
+      typename soft_pwm< p, t, b, k, typename p::has_port_out >::value_type
+         soft_pwm< p, t, b, k, typename p::has_port_out >::shown[ b ];
+   
+   template< class p, class t, unsigned int b, class k >
+      typename soft_pwm< p, t, b, k, typename p::has_port_out >::value_type
+         soft_pwm< p, t, b, k, typename p::has_port_out >::next[ b ];
+   
+   template< class p, class t, unsigned int b, class k >
+      volatile bool 
+         soft_pwm< p, t, b, k, typename p::has_port_out >::pending;
+   
+   template< class p, class t, unsigned int b, class k >
+      unsigned int 
+         soft_pwm< p, t, b, k, typename p::has_port_out >::plane;
+   
+   template< class p, class t, unsigned int b, class k >
+      typename soft_pwm< p, t, b, k, typename p::has_port_out >::moment
+         soft_pwm< p, t, b, k, typename p::has_port_out >::epoch;
+   
+   // from a port_in_out: convert it to a port_out
+   template< 
+      class port, 
+      class timing,
+      unsigned int bits,
+      class tick
+   >
+   struct soft_pwm< 
+      port, 
+      timing, 
+      bits, 
+      tick, 
+      typename port::has_port_in_out 
+   > :
+      public soft_pwm< port_out_from< port >, timing, bits, tick >
+   {};
+   
+   // from a port_oc: convert it to a port_out
+   template< 
+      class port, 
+      class timing,
+      unsigned int bits,
+      class tick
+   >
+   struct soft_pwm< 
+      port, 
+      timing, 
+      bits, 
+      tick, 
+      typename port::has_port_oc 
+   > :
+      public soft_pwm< port_out_from< port >, timing, bits, tick >
+   {};
+   
+   
+   // =======================================================================
+   //
+   // traced
+   //
+   // =======================================================================
+   
+   // in pins.hpp:
+   // fallback: compiler error
+   // template< 
+   //    class unsupported, 
+   //    class recorder = void,
+   //    class dummy = void 
+   // > struct traced { . . . }; 
+   
+   // from a port_in: count and trace get()
+   template< class port, class recorder >
+   struct traced< port, recorder, typename port::has_port_in > :
+      public port_in_archetype< port::n_pins >,
+      public _traced_counters< port, recorder, port::n_pins >
+   {
+      typedef _traced_counters< port, recorder, port::n_pins > counters;
+      typedef typename port::value_type value_type;
+      
+      static void init( const char * name = nullptr ){ 
+         port::init(); 
+         counters::trace_init( name, "port" );
+      }
+      
+      static value_type get(){ 
+         return counters::trace_get( port::get() ); 
+      }
+   };
+   
+   // from a port_out: count and trace set()
+   template< class port, class recorder >
+   struct traced< port, recorder, typename port::has_port_out > :
+      public port_out_archetype< port::n_pins >,
+      public _traced_counters< port, recorder, port::n_pins >
+   {
+      typedef _traced_counters< port, recorder, port::n_pins > counters;
+      typedef typename port::value_type value_type;
+      
+      static void init( const char * name = nullptr ){ 
+         port::init(); 
+         counters::trace_init( name, "port" );
+      }
+      
+      static void set( value_type x ){ 
+         counters::trace_set( x ); 
+         port::set( x ); 
+      }
+   };
+   
+   // from a port_in_out: count the direction calls, count and trace
+   // set() and get()
+   template< class port, class recorder >
+   struct traced< port, recorder, typename port::has_port_in_out > :
+      public port_in_out_archetype< port::n_pins >,
+      public _traced_counters< port, recorder, port::n_pins >
+   {
+      typedef _traced_counters< port, recorder, port::n_pins > counters;
+      typedef typename port::value_type value_type;
+      
+      static void init( const char * name = nullptr ){ 
+         port::init(); 
+         counters::trace_init( name, "port" );
+      }
+      
+      static void direction_set_input(){ 
+         counters::n_direction++;
+         port::direction_set_input(); 
+      }
+      
+      static void direction_set_output(){ 
+         counters::n_direction++;
+         port::direction_set_output(); 
+      }
+      
+      static void set( value_type x ){ 
+         counters::trace_set( x ); 
+         port::set( x ); 
+      }
+      
+      static value_type get(){ 
+         return counters::trace_get( port::get() ); 
+      }
+   };
+   
+   // from a port_oc: count and trace set() and get()
+   template< class port, class recorder >
+   struct traced< port, recorder, typename port::has_port_oc > :
+      public port_oc_archetype< port::n_pins >,
+      public _traced_counters< port, recorder, port::n_pins >
+   {
+      typedef _traced_counters< port, recorder, port::n_pins > counters;
+      typedef typename port::value_type value_type;
+      
+      static void init( const char * name = nullptr ){ 
+         port::init(); 
+         counters::trace_init( name, "port" );
+      }
+      
+      static void set( value_type x ){ 
+         counters::trace_set( x ); 
+         port::set( x ); 
+      }
+      
+      static value_type get(){ 
+         return counters::trace_get( port::get() ); 
+      }
+   };
+   
+   
    // =======================================================================
    //
    // kitt
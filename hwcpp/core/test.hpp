@@ -1,4 +1,6 @@
 #include <cstdlib>
+#include <iostream>
+#include <iomanip>
 
 namespace hwcpp {
 	
@@ -22,7 +24,7 @@ namespace hwcpp {
             level = higher->level + 1;
          }
          testcase = this;
-         hwcpp::io:cout << std::setw( 3 * level ) << "" << name << "\n";
+         std::cout << std::setw( 3 * level ) << "" << name << "\n";
       }
       
       ~test(){
@@ -58,3 +60,6 @@ namespace hwcpp {
    }
    
 };
+
+// check a condition in the current test
+#define HWCPP_ASSERT( x ) hwcpp::assert( __FILE__, __LINE__, ( x ))
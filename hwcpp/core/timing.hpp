@@ -10,8 +10,6 @@
 //
 // ==========================================================================
 
-// - ns should contain a duration (instead of calculating it everywhere)
-// - ns should call an implementatio-defined wait template
 // - it must loop when arg > representable....
 // - how to handle that duration when arg > representable??
 
@@ -33,6 +31,11 @@ namespace hwcpp {
    >
    struct moment_duration {
       typedef _base base;
+      
+      static_assert( 
+         ( _ticks_per_us >= 1 ) && ( _ticks_per_us <= 1000 ), 
+         "ticks_per_us must be 1..1000" 
+      );
    
       // common part of duration and moment, provides comparisons and raw()
       // the dummy argument prevents meaningless cross-comparisons
@@ -48,6 +51,19 @@ namespace hwcpp {
       
          constexpr base raw() const { return x; }
          
+         // in us or ns, rounded towards 0, without a run-time division
+         constexpr base to_us() const { 
+            return constant_divider< _ticks_per_us >::divide( x ); 
+         }
+         
+         // the whole us first, so only the remainder is multiplied
+         // and a large tick count does not overflow
+         constexpr base to_ns() const { 
+            return to_us() * 1000
+               + constant_divider< _ticks_per_us >::divide( 
+                  ( x - to_us() * _ticks_per_us ) * 1000 ); 
+         }
+         
          constexpr bool operator<( const common rhs ) const {
             return raw() < rhs.raw();
          }
@@ -87,6 +103,11 @@ namespace hwcpp {
          static constexpr duration infinite = 
             duration( int_info< base >::maximum );      
       
+         // rounded up to a whole tick
+         static constexpr duration ns( base n ){ 
+            return duration( 
+               constant_divider< 1000 >::divide( n * ticks_per_us + 999 ));
+         }
          static constexpr duration us( base n ){ 
             return duration( n * ticks_per_us );
          }
@@ -204,6 +225,101 @@ namespace hwcpp {
    }; // class moment_duration      
    
 
+   // =======================================================================
+   //
+   // Busy loop support
+   //
+   // A waiting or timing support can provide a calibrated busy loop, 
+   // which the ns<>, us<>, ... templates use for short waits (up to 
+   // HWCPP_BUSY_WAIT_NS), with the number of loops calculated at 
+   // compile time. A zero-length wait compiles to nothing.
+   //
+   //    typedef void has_busy_loop;
+   //    static constexpr unsigned long long busy_loop_frequency = ...;
+   //    static constexpr unsigned long long busy_loop_cycles = ...;
+   //    static constexpr unsigned long long busy_loop_overhead = ...;
+   //    static void busy_loop( unsigned int n );
+   //
+   // busy_loop( n ) must take busy_loop_overhead + n * busy_loop_cycles
+   // cycles of busy_loop_frequency, for n >= 1.
+   //
+   // =======================================================================
+   
+   #ifndef HWCPP_BUSY_WAIT_NS
+      #define HWCPP_BUSY_WAIT_NS 100000
+   #endif
+   
+   // inherit this to pass the busy loop of an implementation on 
+   template< class implementation, class dummy = void >
+   struct busy_loop_forward {};
+   
+   template< class implementation >
+   struct busy_loop_forward< 
+      implementation, 
+      typename implementation::has_busy_loop 
+   > {
+      typedef void has_busy_loop;
+      static constexpr unsigned long long busy_loop_frequency = 
+         implementation::busy_loop_frequency;
+      static constexpr unsigned long long busy_loop_cycles = 
+         implementation::busy_loop_cycles;
+      static constexpr unsigned long long busy_loop_overhead = 
+         implementation::busy_loop_overhead;
+      static void busy_loop( unsigned int n ){ 
+         implementation::busy_loop( n ); 
+      }
+   };
+   
+   // wait d ns: use the service's wait()
+   template< 
+      class service, 
+      unsigned long long d, 
+      unsigned long long m, 
+      class dummy = void 
+   >
+   struct _ns_wait {
+      static void wait(){
+         if( d == 0 ){
+            return;
+         }
+         if( m == LLONG_MAX ){
+            service::wait( service::duration::ns( d ));
+         } else {
+            service::wait( 
+               service::duration::ns( d ), 
+               service::duration::ns( m ) 
+            );
+         }
+      }
+   };
+   
+   // wait d ns: use the busy loop when d is short enough
+   template< class service, unsigned long long d, unsigned long long m >
+   struct _ns_wait< service, d, m, typename service::has_busy_loop > {
+      typedef unsigned long long ull;
+      
+      static constexpr bool busy = ( d <= HWCPP_BUSY_WAIT_NS );
+      
+      // rounded up
+      static constexpr ull cycles = busy
+         ? ( d * service::busy_loop_frequency + 999999999 ) / 1000000000
+         : 0;
+      static constexpr ull loops = ( cycles <= service::busy_loop_overhead )
+         ? 0
+         : ( cycles - service::busy_loop_overhead 
+               + service::busy_loop_cycles - 1 ) 
+            / service::busy_loop_cycles;
+      
+      static void wait(){
+         if( ! busy ){
+            _ns_wait< service, d, m, int >::wait();
+         } else if( loops > 0 ){
+            service::busy_loop( loops );
+         }
+      }
+   };
+
+
    // =======================================================================
    //
    // Template-based waiting: common for all timing services
@@ -237,41 +353,38 @@ namespace hwcpp {
          typedef ull base;
          static constexpr base _duration = d;
          static constexpr base margin = m;
-         static constexpr typename _service::duration duration = _service::duration::ms( 1 + ( _duration / 1000 ));
+         static constexpr typename _service::duration duration = 
+            _service::duration::ns( _duration );
          typedef add_timing_templates< _service > service;
          static void init(){ _service::init(); }
          static void wait(){  
-            // should call an implementation-template!! 
             if( d == infinite ){
                for(;;){
-                  _service::wait( duration::us( 1000 ) ); 
+                  _service::wait( _service::duration::us( 1000 )); 
                }
             }
-            if( m == infinite ){
-               _service::wait(
-                  duration::us( 1 + ( _duration / 1000 ))
-               );             
-            } else {
-               _service::wait(
-                  duration::us( 1 + ( _duration / 1000 )),
-                  duration::us( (typename _service::base) margin / 1000 ) 
-               );             
-            }
+            _ns_wait< _service, d, m >::wait();
          }
       };
       
-      template< ull d, ull x = ULLONG_MAX > struct us:  
-         public ns< 1000 * d, 1000 * x >{};
-      template< ull d, ull x = ULLONG_MAX > struct ms:  
-         public us< 1000 * d, 1000 * x >{};
-      template< ull d, ull x = ULLONG_MAX > struct s:   
-         public ms< 1000 * d, 1000 * x >{};
-      template< ull d, ull x = ULLONG_MAX > struct m:   
-         public  s<   60 * d,   60 * x >{};
-      template< ull d, ull x = ULLONG_MAX > struct h:   
-         public  m<   60 * d,   60 * x >{};
-      template< ull d, ull x = ULLONG_MAX > struct day: 
-         public  h<   24 * d,   24 * x >{};
+      // x * f, but infinite (the sentinel for no margin, or for 
+      // waiting forever) and anything that would exceed it stay infinite
+      static constexpr ull scale( ull x, ull f ){
+         return ( x >= infinite / f ) ? infinite : x * f;
+      }
+      
+      template< ull d, ull x = infinite > struct us:  
+         public ns< scale( d, 1000 ), scale( x, 1000 ) >{};
+      template< ull d, ull x = infinite > struct ms:  
+         public us< scale( d, 1000 ), scale( x, 1000 ) >{};
+      template< ull d, ull x = infinite > struct s:   
+         public ms< scale( d, 1000 ), scale( x, 1000 ) >{};
+      template< ull d, ull x = infinite > struct m:   
+         public  s< scale( d,   60 ), scale( x,   60 ) >{};
+      template< ull d, ull x = infinite > struct h:   
+         public  m< scale( d,   60 ), scale( x,   60 ) >{};
+      template< ull d, ull x = infinite > struct day: 
+         public  h< scale( d,   24 ), scale( x,   24 ) >{};
       
       template< ull f >
       struct Hz : public noninstantiable {
@@ -280,8 +393,8 @@ namespace hwcpp {
          static constexpr ull frequency = f;
          typedef add_timing_templates< _service > service;
          static void init(){ _service::init(); }
-         typedef ns< s< 1 >::duration / f > period;
-         typedef ns< s< 1 >::duration / ( 2 * f ) > half_period;
+         typedef ns< 1000ULL * 1000 * 1000 / f > period;
+         typedef ns< 1000ULL * 1000 * 1000 / ( 2 * f ) > half_period;
       };
       
       template< ull f > struct kHz: public  Hz< 1000 * f >{};
@@ -334,7 +447,8 @@ namespace hwcpp {
       class implementation 
    >
    struct waiting_waiter : 
-      public noninstantiable 
+      public noninstantiable,
+      public busy_loop_forward< implementation >
    {
       typedef void has_waiting; 
    
@@ -402,6 +516,82 @@ namespace hwcpp {
    };   
    
    
+   // =======================================================================
+   //
+   // Idle support
+   //
+   // Instead of spinning until a moment, the waits can let the CPU
+   // sleep (or let the host do something else) when the timing support 
+   // provides idle_until( t, pending ), which must return at or (for 
+   // instance when an interrupt occurs) before t. The wait sleeps until 
+   // idle_margin ticks before the deadline, and spins for the remainder.
+   //
+   // When pending is not nullptr, idle_until must call it right before
+   // it sleeps, with the interrupts masked, and not sleep when it 
+   // returns true. An interrupt that makes pending() true after that
+   // check must still end the sleep (as it does a WFI with the 
+   // interrupts masked), so the wakeup it causes is not lost.
+   //
+   //    typedef void has_idle_until;
+   //    static constexpr base idle_margin = ...;
+   //    static void idle_until( base t, bool (*pending)() = nullptr );
+   //
+   // When HWCPP_IDLE_STATISTICS is defined as 1 the number of sleeps,
+   // the total time asleep (to calculate the idle fraction) and the 
+   // maximum lateness of the wakeups (in ticks) are counted.
+   //
+   // =======================================================================
+   
+   #ifndef HWCPP_IDLE_STATISTICS
+      #define HWCPP_IDLE_STATISTICS 0
+   #endif
+   
+   // no idle support: spin
+   template< class implementation, class dummy = void >
+   struct idle {
+      typedef typename implementation::base base;
+      static void until( base now, base t, bool (*pending)() = nullptr ){}
+   };
+   
+   template< class implementation >
+   struct idle< implementation, typename implementation::has_idle_until > {
+      typedef typename implementation::base base;
+      
+      #if HWCPP_IDLE_STATISTICS
+         static unsigned int n_sleeps;
+         static base asleep;
+         static base latency_max;
+      #endif
+      
+      // sleep from now until shortly before t, if worthwhile,
+      // and not when pending() is true
+      static void until( base now, base t, bool (*pending)() = nullptr ){
+         if( t - now <= implementation::idle_margin ){
+            return;
+         }
+         base wakeup = t - implementation::idle_margin;
+         implementation::idle_until( wakeup, pending );
+         #if HWCPP_IDLE_STATISTICS
+            base awake = implementation::now();
+            n_sleeps++;
+            asleep += awake - now;
+            if( awake - wakeup > latency_max ){
+               latency_max = awake - wakeup;
+            }
+         #endif
+      }
+   };
+   
+   #if HWCPP_IDLE_STATISTICS
+      template< class i > 
+         unsigned int idle< i, typename i::has_idle_until >::n_sleeps;
+      template< class i > 
+         typename i::base idle< i, typename i::has_idle_until >::asleep;
+      template< class i > 
+         typename i::base idle< i, typename i::has_idle_until >::latency_max;
+   #endif
+   
+   
    // =======================================================================
    //
    // Timing implementation
@@ -416,7 +606,10 @@ namespace hwcpp {
    template< 
       class implementation 
    >
-   struct timing_waiter : public noninstantiable {
+   struct timing_waiter : 
+      public noninstantiable,
+      public busy_loop_forward< implementation >
+   {
       HARDWARE_REQUIRE_ARCHETYPE( implementation, has_timing_support ); 
 
       typedef void has_waiting;      
@@ -434,7 +627,13 @@ namespace hwcpp {
       static moment now(){ return moment( implementation::now() ); }
       
       static void wait( const moment t ){
-         while( now() < t );
+         for(;;){
+            moment n = now();
+            if( n >= t ){
+               return;
+            }
+            idle< implementation >::until( n.raw(), t.raw() );
+         }
       }
       
       static void wait( const duration d ){
@@ -512,6 +711,338 @@ namespace hwcpp {
    }; // class callback
       
 
+   // =======================================================================
+   //
+   // Callback statistics
+   //
+   // When HWCPP_CALLBACK_STATISTICS is defined as 1 each timer and 
+   // clock counts its activations, and records the minimum, maximum 
+   // and total lateness (the moment it was called minus its epoch) 
+   // and the maximum run time of its function(). These can be read,
+   // and printed as us to an ostream:
+   //
+   //    io::cout << blink_clock.statistics() << "\n";
+   //
+   // For all callbacks together the activations and the batches (the
+   // activations by the same update) are counted, their ratio shows 
+   // how well timer slack groups the callbacks.
+   //
+   // Otherwise the statistics and their administration are empty.
+   //
+   // =======================================================================
+   
+   #ifndef HWCPP_CALLBACK_STATISTICS
+      #define HWCPP_CALLBACK_STATISTICS 0
+   #endif
+   
+   #if HWCPP_CALLBACK_STATISTICS
+   
+   template< class _timing >
+   struct callback_statistics {
+      typedef typename _timing::moment moment;
+      typedef typename _timing::duration duration;
+      
+      unsigned int activations;
+      duration late_min;
+      duration late_max;
+      duration late_total;
+      duration run_max;
+      
+      callback_statistics(){
+         statistics_clear();
+      }
+      
+      void statistics_clear(){
+         activations = 0;
+         late_min = duration::infinite;
+         late_max = duration( 0 );
+         late_total = duration( 0 );
+         run_max = duration( 0 );
+      }
+      
+      duration late_mean() const {
+         return ( activations == 0 ) 
+            ? duration( 0 ) 
+            : late_total / (int) activations;
+      }
+      
+      const callback_statistics & statistics() const {
+         return *this;
+      }
+      
+      // the activations of all callbacks, and the number of batches:
+      // groups of activations by the same update()
+      static unsigned int activations_total;
+      static unsigned int batches_total;
+      
+      // activations per batch, * 100
+      static unsigned int batching_ratio_100(){
+         return ( batches_total == 0 ) 
+            ? 0 
+            : ( 100 * activations_total ) / batches_total;
+      }
+      
+      template< class stream >
+      friend stream & operator<<( stream & s, const callback_statistics & x ){
+         // a << of a derived stream returns its base, so return s itself
+         if( x.activations == 0 ){
+            s << "n=0";
+            return s;
+         }
+         s 
+            << "n=" << x.activations
+            << " late us min=" << (long long int) x.late_min.to_us()
+            << " mean=" << (long long int) x.late_mean().to_us()
+            << " max=" << (long long int) x.late_max.to_us()
+            << " run us max=" << (long long int) x.run_max.to_us();
+         return s;
+      }
+      
+   protected:
+   
+      moment activation_begin( const moment epoch, const moment now ){
+      
+         // the callbacks serviced by one update() get the same now
+         static moment batch_now;
+         if(( batches_total == 0 ) || ( now != batch_now )){
+            batches_total++;
+            batch_now = now;
+         }
+         activations_total++;
+         
+         duration late = now - epoch;
+         activations++;
+         late_total += late;
+         if( late < late_min ){
+            late_min = late;
+         }
+         if( late > late_max ){
+            late_max = late;
+         }
+         return _timing::now();
+      }
+      
+      void activation_end( const moment start ){
+         duration run = _timing::now() - start;
+         if( run > run_max ){
+            run_max = run;
+         }
+      }
+   };
+   
+   template< class _timing >
+      unsigned int callback_statistics< _timing >::activations_total;
+   template< class _timing >
+      unsigned int callback_statistics< _timing >::batches_total;
+   
+   #else
+   
+   template< class _timing >
+   struct callback_statistics {
+      typedef typename _timing::moment moment;
+      
+   protected:
+   
+      moment activation_begin( const moment epoch, const moment now ){
+         return now;
+      }
+      
+      void activation_end( const moment start ){}
+   };
+   
+   #endif
+   
+   
+   // =======================================================================
+   //
+   // Timer slack
+   //
+   // A timer that is started with a slack can fire at any moment from 
+   // its epoch to its epoch + slack. Its epoch is moved to the moment 
+   // in that window that is the multiple of the highest power of 2 
+   // ticks, so timers with overlapping windows tend to get the same 
+   // epoch, and are serviced together: by the same update() of an 
+   // administration that services all due callbacks, and after the 
+   // same sleep.
+   //
+   // =======================================================================
+   
+   // the moment from m to m + slack with the most trailing zero bits
+   template< class moment, class duration >
+   moment _slack_align( const moment m, const duration slack ){
+      if( slack.raw() <= 0 ){
+         return m;
+      }
+      unsigned long long low = m.raw();
+      unsigned long long high = low + slack.raw();
+      
+      // the bits below the highest bit in which low and high differ 
+      unsigned long long below = low ^ high;
+      for( int i = 1; i < 64; i *= 2 ){
+         below |= below >> i;
+      }
+      below >>= 1;
+      
+      return m + duration(( high & ~ below ) - low );
+   }
+   
+   
+   // =======================================================================
+   //
+   // Clock catch-up policy
+   //
+   // What a clock does when it is serviced so late that one or more 
+   // of its next epochs have passed too:
+   //
+   // catch_up : call function() for each epoch, back-to-back
+   // skip     : call function() once, skip the passed epochs, and add 
+   //            their number to missed_total()
+   // coalesce : call function( missed ) once, with the number of 
+   //            passed epochs, and add it to missed_total()
+   //
+   // =======================================================================
+   
+   enum class clock_policy { catch_up, skip, coalesce };
+   
+   // advance epoch to the next epoch that is not before now
+   // (or by one interval for catch_up), return the number skipped
+   template< clock_policy policy, class moment, class duration >
+   unsigned int _clock_advance( 
+      moment & epoch, 
+      const duration interval, 
+      const moment now 
+   ){
+      epoch += interval;
+      unsigned int missed = 0;
+      if(( policy != clock_policy::catch_up ) && ( epoch < now )){
+      
+         // the passed epochs in one division, so a long stall does
+         // not cost a loop iteration per epoch (the interval is a 
+         // run-time value, so constant_divider does not apply)
+         long long n = ( now - epoch - duration( 1 )) / interval + 1;
+         epoch += interval * n;
+         missed = n;
+      }
+      return missed;
+   }
+   
+   // the common part of the clocks of the administrations
+   template< class _timing, class node, clock_policy policy >
+   class _clock_base : 
+      public node 
+   {
+   private:
+      void cancel();
+      unsigned int missed;
+      
+   protected:
+      typename _timing::duration interval;
+      
+      _clock_base( const typename _timing::duration interval )
+         : missed( 0 ), interval( interval ){}
+         
+      // advance the epoch, call function() or function( missed )
+      void tick( const typename _timing::moment now, bool reinsert ){
+         typename _timing::moment epoch = this->epoch;
+         unsigned int n = 
+            _clock_advance< policy >( this->epoch, interval, now );
+         missed += n;
+         if( reinsert ){
+            this->insert();
+         }
+         typename _timing::moment start = 
+            this->activation_begin( epoch, now );
+         if( policy == clock_policy::coalesce ){
+            this->function( n );
+         } else {
+            this->function();
+         }
+         this->activation_end( start );
+      }
+      
+   public:
+   
+      // the total number of skipped epochs
+      unsigned int missed_total() const {
+         return missed;
+      }
+      
+      // called instead of function() for clock_policy::coalesce
+      virtual void function( unsigned int missed ){}
+      
+      using node::function;
+   };
+   
+   
+   // =======================================================================
+   //
+   // Starting timers from an interrupt
+   //
+   // The administrations are not interrupt safe, so an interrupt 
+   // handler can not call start(). It can call start_from_isr(), which 
+   // puts the node and its epoch in a queue that the next update() 
+   // (or next_deadline()) moves into the administration. The queue is 
+   // a ring buffer with a single producer (the interrupt handler) and 
+   // a single consumer (the main code), see spsc_ring. The handlers 
+   // that call start_from_isr() must not interrupt each other.
+   //
+   // HWCPP_CALLBACK_ISR_QUEUE is the size of the queue, a power of 2.
+   // When the queue is full start_from_isr() returns false.
+   //
+   // An interrupt ends an idle sleep, so the timer is taken into
+   // account by the wait() that was sleeping. A start_from_isr() 
+   // between the drain and the sleep would not end that sleep, so 
+   // the wait passes isr_pending() to idle_until(), which checks the 
+   // queue with the interrupts masked right before it sleeps.
+   //
+   // =======================================================================
+   
+   #ifndef HWCPP_CALLBACK_ISR_QUEUE
+      #define HWCPP_CALLBACK_ISR_QUEUE 8
+   #endif
+   
+   template< class _timing, class _node >
+   struct _callback_isr_queue {
+   
+      static constexpr unsigned int size = HWCPP_CALLBACK_ISR_QUEUE;
+      
+      struct entry {
+         _node * p;
+         typename _timing::moment epoch;
+      };
+      
+      static spsc_ring< entry, size > queue;
+      
+      // called from the interrupt handler
+      static bool push( _node * p, const typename _timing::moment m ){
+         entry e;
+         e.p = p;
+         e.epoch = m;
+         return queue.push( e );
+      }
+      
+      // called from the main code: insert the queued nodes
+      static void drain(){
+         entry e;
+         while( queue.pop( e )){
+            e.p->epoch = e.epoch;
+            e.p->insert();
+         }
+      }
+      
+      // called from the main code: queued nodes that are not inserted
+      static bool pending(){
+         return ! queue.empty();
+      }
+   };
+   
+   template< class t, class n > 
+      spsc_ring< 
+         typename _callback_isr_queue< t, n >::entry, 
+         HWCPP_CALLBACK_ISR_QUEUE 
+      > _callback_isr_queue< t, n >::queue;
+   
+   
    // =======================================================================
    //
    // The default implementation of the callback administration,
@@ -571,6 +1102,7 @@ namespace hwcpp {
    public:
       
       static void update( const typename _timing::moment now ){
+         _callback_isr_queue< _timing, _node >::drain();
          _node *root = _node::root_get();
          for( 
             _node *p = root->next; 
@@ -583,14 +1115,52 @@ namespace hwcpp {
             }   
          }   
       }      
+      
+      // the earliest epoch, but not after limit
+      static typename _timing::moment next_deadline( 
+         const typename _timing::moment limit 
+      ){
+         _callback_isr_queue< _timing, _node >::drain();
+         typename _timing::moment result = limit;
+         _node *root = _node::root_get();
+         for( 
+            _node *p = root->next; 
+            p != root; 
+            p = p->next
+         ){   
+            if( p->epoch < result ){
+               result = p->epoch;
+            }   
+         }   
+         return result;
+      }      
+      
+      // a start_from_isr() that next_deadline() has not seen
+      static bool isr_pending(){
+         return _callback_isr_queue< _timing, _node >::pending();
+      }
                          
       struct node : 
-         protected _node 
+         protected _node,
+         public callback_statistics< _timing >
       {       
          void cancel(){ _node::cancel(); }
          // virtual 
          ~node(){ _node::cancel(); }
          virtual void function(){}       
+         
+      protected:
+      
+         // call function(), for the epoch
+         void activate( 
+            const typename _timing::moment epoch, 
+            const typename _timing::moment now 
+         ){
+            typename _timing::moment start = 
+               this->activation_begin( epoch, now );
+            this->function();
+            this->activation_end( start );
+         }
       };
       
       template< class d = void, class dummy = void >
@@ -609,10 +1179,36 @@ namespace hwcpp {
          void start( const typename _timing::duration t ){
             start( _timing::now() + t );
          }
+         
+         // start for any moment from m to m + slack, aligned
+         // so that it will likely fire together with other timers
+         void start( 
+            const typename _timing::moment m, 
+            const typename _timing::duration slack 
+         ){
+            start( _slack_align( m, slack ));
+         }
+            
+         void start( 
+            const typename _timing::duration t, 
+            const typename _timing::duration slack 
+         ){
+            start( _timing::now() + t, slack );
+         }
+         
+         // start from an interrupt handler, false when the queue is full
+         bool start_from_isr( const typename _timing::moment m ){
+            return _callback_isr_queue< _timing, _node >::push( this, m );
+         }
+         
+         // requires a now() that can be called from an interrupt handler
+         bool start_from_isr( const typename _timing::duration t ){
+            return start_from_isr( _timing::now() + t );
+         }
             
          void visit( const typename _timing::moment now ) override {
             this->cancel();
-            this->function();
+            this->activate( this->epoch, now );
          }
             
       };
@@ -624,64 +1220,704 @@ namespace hwcpp {
 
          void start( 
             const typename _timing::duration t
-               = typename _timing::duration::ms ( 1 + d::duration / 1000 )
+               = _timing::duration::ns( d::_duration )
          ){
             timer<>::start( t );           
          }
          
       };         
 
-      template< class d = void, class dummy = void >
+      template< 
+         class d = void, 
+         clock_policy policy = clock_policy::catch_up, 
+         class dummy = void 
+      >
       class clock : 
-         public node 
+         public _clock_base< _timing, node, policy > 
       {
-      private:
-         void cancel();
-         typename _timing::duration interval;
-               
       public:
          
          clock( const typename _timing::duration interval )
-            : interval( interval )
+            : _clock_base< _timing, node, policy >( interval )
          {
             this->epoch = _timing::now() + interval;
             this->insert();
          }
             
          void visit( const typename _timing::moment now ) override {
-            this->epoch += this->interval;
-            this->function();              
+            this->tick( now, false );
          }
             
       };
       
-      template< class d > 
-      struct clock< d, typename d::has_duration > : 
-         public clock<> 
+      template< class d, clock_policy policy > 
+      struct clock< d, policy, typename d::has_duration > : 
+         public clock< void, policy > 
       {
          clock(): 
-            clock<>( _timing::duration::ms( 1 + d::duration / 1000 )){};
+            clock< void, policy >( _timing::duration::ns( d::_duration )){};
       };   
         
-      template< class d > 
-      struct clock< d, typename d::has_frequency > : 
-         public clock<> 
+      template< class d, clock_policy policy > 
+      struct clock< d, policy, typename d::has_frequency > : 
+         public clock< void, policy > 
       {
          clock(): 
-            clock<>( _timing::duration::ms( 
-               1 + d::period::duration / 1000 )){};
+            clock< void, policy >( 
+               _timing::duration::ns( d::period::_duration )){};
       };   
    
       
    }; // class callback_double_linked
    
    
+   // =======================================================================
+   //
+   // the node, timer and clock classes for a callback administration,
+   // given the _node class of that administration, which must provide
+   // epoch, insert() (insert or re-insert according to epoch), 
+   // cancel() (if inserted) and a virtual visit( now ).
+   //
+   // =======================================================================
+   
+   template< class _timing, class _node >
+   struct _callback_nodes {
+   
+      struct node : 
+         protected _node,
+         public callback_statistics< _timing >
+      {       
+         void cancel(){ _node::cancel(); }
+         // virtual 
+         ~node(){ _node::cancel(); }
+         virtual void function(){}       
+         
+      protected:
+      
+         // call function(), for the epoch
+         void activate( 
+            const typename _timing::moment epoch, 
+            const typename _timing::moment now 
+         ){
+            typename _timing::moment start = 
+               this->activation_begin( epoch, now );
+            this->function();
+            this->activation_end( start );
+         }
+      };
+      
+      template< class d = void, class dummy = void >
+      struct timer : 
+         public node 
+      {
+      
+         void cancel(){ node::cancel(); }
+      
+         void start( const typename _timing::moment m ){
+            this->epoch = m;
+            this->insert();           
+         }
+            
+         void start( const typename _timing::duration t ){
+            start( _timing::now() + t );
+         }
+         
+         // start for any moment from m to m + slack, aligned
+         // so that it will likely fire together with other timers
+         void start( 
+            const typename _timing::moment m, 
+            const typename _timing::duration slack 
+         ){
+            start( _slack_align( m, slack ));
+         }
+            
+         void start( 
+            const typename _timing::duration t, 
+            const typename _timing::duration slack 
+         ){
+            start( _timing::now() + t, slack );
+         }
+         
+         // start from an interrupt handler, false when the queue is full
+         bool start_from_isr( const typename _timing::moment m ){
+            return _callback_isr_queue< _timing, _node >::push( this, m );
+         }
+         
+         // requires a now() that can be called from an interrupt handler
+         bool start_from_isr( const typename _timing::duration t ){
+            return start_from_isr( _timing::now() + t );
+         }
+            
+         void visit( const typename _timing::moment now ) override {
+            this->cancel();
+            this->activate( this->epoch, now );
+         }
+            
+      };
+      
+      template< class d > 
+      struct timer< d, typename d::has_duration > : 
+         public timer<> 
+      {
+
+         void start( 
+            const typename _timing::duration t
+               = _timing::duration::ns( d::_duration )
+         ){
+            timer<>::start( t );           
+         }
+         
+      };         
+
+      template< 
+         class d = void, 
+         clock_policy policy = clock_policy::catch_up, 
+         class dummy = void 
+      >
+      class clock : 
+         public _clock_base< _timing, node, policy > 
+      {
+      public:
+         
+         clock( const typename _timing::duration interval )
+            : _clock_base< _timing, node, policy >( interval )
+         {
+            this->epoch = _timing::now() + interval;
+            this->insert();
+         }
+            
+         void visit( const typename _timing::moment now ) override {
+            this->tick( now, true );
+         }
+            
+      };
+      
+      template< class d, clock_policy policy > 
+      struct clock< d, policy, typename d::has_duration > : 
+         public clock< void, policy > 
+      {
+         clock(): 
+            clock< void, policy >( _timing::duration::ns( d::_duration )){};
+      };   
+        
+      template< class d, clock_policy policy > 
+      struct clock< d, policy, typename d::has_frequency > : 
+         public clock< void, policy > 
+      {
+         clock(): 
+            clock< void, policy >( 
+               _timing::duration::ns( d::period::_duration )){};
+      };   
+      
+   }; // struct _callback_nodes
+   
+   
+   // =======================================================================
+   //
+   // A callback administration using a pairing heap ordered by epoch.
+   //
+   // Inserting a callback takes constant time, servicing and canceling
+   // take (amortized) logarithmic time. An update() services all
+   // callbacks that are due, each once, in epoch order.
+   //
+   // =======================================================================
+   
+   template< class _timing >
+   struct _callback_heap_node : 
+      public noncopyable 
+   {
+      typedef typename _timing::moment moment;
+   
+      enum class state { idle, queued, due };
+      
+      _callback_heap_node * child;
+      _callback_heap_node * sibling;
+      
+      // the parent when this is the first child, otherwise
+      // the previous sibling
+      _callback_heap_node * previous;
+      
+      // the next node in the chain of due nodes
+      _callback_heap_node * due_next;
+      
+      state status;
+      moment epoch;
+      
+      constexpr _callback_heap_node(): 
+         child( nullptr ), 
+         sibling( nullptr ), 
+         previous( nullptr ), 
+         due_next( nullptr ), 
+         status( state::idle ){}
+      
+      static _callback_heap_node *& root(){
+         static _callback_heap_node * _root = nullptr;
+         return _root;
+      }
+      
+      // meld two heaps, return the new root
+      static _callback_heap_node * meld( 
+         _callback_heap_node * a, 
+         _callback_heap_node * b 
+      ){
+         if( a == nullptr ){
+            return b;
+         }
+         if( b == nullptr ){
+            return a;
+         }
+         if( b->epoch < a->epoch ){
+            _callback_heap_node * t = a;
+            a = b;
+            b = t;
+         }
+         b->previous = a;
+         b->sibling = a->child;
+         if( a->child != nullptr ){
+            a->child->previous = b;
+         }
+         a->child = b;
+         return a;
+      }
+      
+      // meld a list of sibling heaps (two-pass), return the new root
+      static _callback_heap_node * merge_pairs( _callback_heap_node * first ){
+      
+         // meld pairs from left to right, chain the results 
+         // in reverse order
+         _callback_heap_node * pairs = nullptr;
+         while( first != nullptr ){
+            _callback_heap_node * a = first;
+            _callback_heap_node * b = a->sibling;
+            first = ( b == nullptr ) ? nullptr : b->sibling;
+            a->sibling = nullptr;
+            a->previous = nullptr;
+            if( b != nullptr ){
+               b->sibling = nullptr;
+               b->previous = nullptr;
+            }
+            _callback_heap_node * m = meld( a, b );
+            m->sibling = pairs;
+            pairs = m;
+         }
+         
+         // meld the results from right to left
+         _callback_heap_node * result = nullptr;
+         while( pairs != nullptr ){
+            _callback_heap_node * next = pairs->sibling;
+            pairs->sibling = nullptr;
+            result = meld( result, pairs );
+            pairs = next;
+         }
+         return result;
+      }
+      
+      void cancel(){
+         if( status == state::due ){
+            status = state::idle;
+         }
+         if( status != state::queued ){
+            return;
+         }
+         if( this == root() ){
+            root() = merge_pairs( child );
+         } else {
+            if( previous->child == this ){
+               previous->child = sibling;
+            } else {
+               previous->sibling = sibling;
+            }
+            if( sibling != nullptr ){
+               sibling->previous = previous;
+            }
+            root() = meld( root(), merge_pairs( child ));
+         }
+         child = nullptr;
+         sibling = nullptr;
+         previous = nullptr;
+         status = state::idle;
+      }
+      
+      void insert(){
+         cancel();
+         status = state::queued;
+         root() = meld( root(), this );
+      }
+      
+      virtual void visit( const moment m ){}
+      
+      static void update( const moment now ){
+      
+         // first take all due nodes from the heap, because
+         // a clock re-inserts itself when it is visited
+         _callback_heap_node * first = nullptr;
+         _callback_heap_node ** last = &first;
+         while(( root() != nullptr ) && ( root()->epoch < now )){
+            _callback_heap_node * p = root();
+            p->cancel();
+            p->status = state::due;
+            p->due_next = nullptr;
+            *last = p;
+            last = &p->due_next;
+         }
+         
+         // a visit can cancel or restart a node that is still due
+         for( _callback_heap_node * p = first; p != nullptr; ){
+            _callback_heap_node * next = p->due_next;
+            if( p->status == state::due ){
+               p->status = state::idle;
+               p->visit( now );
+            }
+            p = next;
+         }
+      }
+   };
+   
+   template< class _timing >      
+   class callback_administration_pairing_heap : 
+      public _timing,
+      public _callback_nodes< _timing, _callback_heap_node< _timing > >
+   {
+   private:
+   
+      HARDWARE_REQUIRE_ARCHETYPE( _timing, has_timing ); 
+      
+   public:
+   
+      static void update( const typename _timing::moment now ){
+         _callback_isr_queue< 
+            _timing, _callback_heap_node< _timing > >::drain();
+         _callback_heap_node< _timing >::update( now );
+      }
+      
+      // the earliest epoch, but not after limit
+      static typename _timing::moment next_deadline( 
+         const typename _timing::moment limit 
+      ){
+         _callback_isr_queue< 
+            _timing, _callback_heap_node< _timing > >::drain();
+         _callback_heap_node< _timing > * root = 
+            _callback_heap_node< _timing >::root();
+         return (( root != nullptr ) && ( root->epoch < limit )) 
+            ? root->epoch 
+            : limit;
+      }
+      
+      // a start_from_isr() that next_deadline() has not seen
+      static bool isr_pending(){
+         return _callback_isr_queue< 
+            _timing, _callback_heap_node< _timing > >::pending();
+      }
+      
+   }; // class callback_administration_pairing_heap
+   
+   
+   // =======================================================================
+   //
+   // A callback administration using a hierarchical timing wheel.
+   //
+   // Each level has a number of slots (a power of 2), a slot of 
+   // level 0 covers a tick of tick_us microseconds, a slot of a level
+   // covers all slots of the level below it. A callback is put in
+   // the slot of the lowest level that covers its epoch. When the 
+   // time enters a slot of a higher level, its callbacks are moved 
+   // to the lower levels. An update() services all callbacks that are
+   // due, each once.
+   //
+   // Inserting and canceling a callback takes constant time,
+   // servicing is proportional to the number of ticks passed
+   // and callbacks due. The wheel uses levels * slots pointers of 
+   // RAM, and covers slots^levels ticks. Callbacks beyond that are
+   // put in the last slot and re-inserted when their slot is reached.
+   //
+   // Use an alias template to select other parameters:
+   //
+   //    template< class t > using my_wheel = 
+   //       callback_administration_wheel< t, 64, 3, 100 >;
+   //
+   // =======================================================================
+   
+   template< 
+      class _timing, 
+      unsigned int slots, 
+      unsigned int levels, 
+      unsigned int tick_us 
+   >
+   struct _callback_wheel_node : 
+      public noncopyable 
+   {
+      static_assert( 
+         ( slots > 1 ) && (( slots & ( slots - 1 )) == 0 ), 
+         "timing wheel slots must be a power of 2" 
+      );
+      static_assert( 
+         levels > 0, 
+         "timing wheel must have at least one level" 
+      );
+   
+      typedef typename _timing::moment moment;
+      typedef typename _timing::base base;
+      
+      static constexpr base tick = tick_us * _timing::duration::ticks_per_us;
+      static constexpr int slot_bits = _bits_needed( slots - 1 );
+      static constexpr unsigned int slot_mask = slots - 1;
+      
+      _callback_wheel_node * next;
+      _callback_wheel_node ** previous_next;
+      moment epoch;
+      
+      // the slots, each a chain of nodes
+      static _callback_wheel_node * wheel[ levels ][ slots ];
+      
+      // the tick of the slot at level 0 that is serviced next
+      static base current;
+      
+      static unsigned int n_nodes;
+      
+      constexpr _callback_wheel_node(): 
+         next( nullptr ), 
+         previous_next( nullptr ){}
+      
+      void cancel(){
+         if( previous_next == nullptr ){
+            return;
+         }
+         *previous_next = next;
+         if( next != nullptr ){
+            next->previous_next = previous_next;
+         }
+         next = nullptr;
+         previous_next = nullptr;
+         n_nodes--;
+      }
+      
+      // put this node in the slot that covers its epoch
+      void enter(){
+         base t = constant_divider< tick >::divide( epoch.raw() );
+         if( t < current ){
+            t = current;
+         }
+         base delta = t - current;
+         unsigned int level = 0;
+         while(
+            ( level + 1 < levels ) 
+            && (( delta >> ( slot_bits * ( level + 1 ))) != 0 )
+         ){
+            level++;
+         }
+         if(( delta >> ( slot_bits * ( level + 1 ))) != 0 ){
+            // beyond the wheel: the last slot of the top level
+            t = current + ( (base) slot_mask << ( slot_bits * level ));
+         }
+         _callback_wheel_node ** head = 
+            &wheel[ level ][ ( t >> ( slot_bits * level )) & slot_mask ];
+         next = *head;
+         if( next != nullptr ){
+            next->previous_next = &next;
+         }
+         *head = this;
+         previous_next = head;
+         n_nodes++;
+      }
+      
+      void insert(){
+         cancel();
+         if( n_nodes == 0 ){
+            current = constant_divider< tick >::divide( 
+               _timing::now().raw() );
+         }
+         enter();
+      }
+      
+      virtual void visit( const moment m ){}
+      
+      // move the chain of a slot to chain
+      static void take( 
+         _callback_wheel_node *& head, 
+         _callback_wheel_node *& chain 
+      ){
+         chain = head;
+         if( chain != nullptr ){
+            chain->previous_next = &chain;
+         }
+         head = nullptr;
+      }
+      
+      // move the nodes of the higher level slots that cover current
+      // to the lower levels
+      static void cascade(){
+         for( unsigned int level = levels - 1; level > 0; level-- ){
+            base below = ( (base) 1 << ( slot_bits * level )) - 1;
+            if(( current & below ) != 0 ){
+               continue;
+            }
+            _callback_wheel_node * chain;
+            take( 
+               wheel[ level ][ ( current >> ( slot_bits * level )) & slot_mask ],
+               chain
+            );
+            while( chain != nullptr ){
+               _callback_wheel_node * p = chain;
+               p->cancel();
+               p->enter();
+            }
+         }
+      }
+      
+      // service the due nodes in the current slot of level 0
+      static void service( const moment now ){
+         _callback_wheel_node * chain;
+         take( wheel[ 0 ][ current & slot_mask ], chain );
+         while( chain != nullptr ){
+            _callback_wheel_node * p = chain;
+            p->cancel();
+            if( p->epoch < now ){
+               p->visit( now );
+            } else {
+               p->enter();
+            }
+         }
+      }
+      
+      // the earliest epoch in the first used slot of level 0, or the
+      // start of the next slot of level 1 when that is earlier and the 
+      // higher levels are used, but not after limit
+      static moment next_deadline( const moment limit ){
+         moment result = limit;
+         if( n_nodes == 0 ){
+            return result;
+         }
+         for( unsigned int i = 0; i < slots; i++ ){
+            _callback_wheel_node * p = wheel[ 0 ][ ( current + i ) & slot_mask ];
+            if( p != nullptr ){
+               for( ; p != nullptr; p = p->next ){
+                  if( p->epoch < result ){
+                     result = p->epoch;
+                  }
+               }
+               break;
+            }
+         }
+         for( unsigned int level = 1; level < levels; level++ ){
+            for( unsigned int i = 0; i < slots; i++ ){
+               if( wheel[ level ][ i ] != nullptr ){
+                  base next = 
+                     ((( current >> slot_bits ) + 1 ) << slot_bits ) * tick;
+                  if( next < result.raw() ){
+                     result -= 
+                        typename _timing::duration( result.raw() - next );
+                  }
+                  return result;
+               }
+            }
+         }
+         return result;
+      }
+      
+      static void update( const moment now ){
+         base target = constant_divider< tick >::divide( now.raw() );
+         for(;;){
+            if( n_nodes == 0 ){
+               current = target;
+               return;
+            }
+            service( now );
+            if( current >= target ){
+               return;
+            }
+            
+            // nodes that were re-inserted for a passed epoch 
+            // move on to the next slot
+            _callback_wheel_node * chain;
+            take( wheel[ 0 ][ current & slot_mask ], chain );
+            current++;
+            cascade();
+            while( chain != nullptr ){
+               _callback_wheel_node * p = chain;
+               p->cancel();
+               p->enter();
+            }
+         }
+      }
+   };
+   
+   template< class t, unsigned int s, unsigned int l, unsigned int u >
+      _callback_wheel_node< t, s, l, u > * 
+         _callback_wheel_node< t, s, l, u >::wheel[ l ][ s ];
+   
+   template< class t, unsigned int s, unsigned int l, unsigned int u >
+      typename _callback_wheel_node< t, s, l, u >::base
+         _callback_wheel_node< t, s, l, u >::current;
+   
+   template< class t, unsigned int s, unsigned int l, unsigned int u >
+      unsigned int _callback_wheel_node< t, s, l, u >::n_nodes;
+   
+   template< 
+      class _timing, 
+      unsigned int slots = 32, 
+      unsigned int levels = 4, 
+      unsigned int tick_us = 1000 
+   >      
+   class callback_administration_wheel : 
+      public _timing,
+      public _callback_nodes< 
+         _timing, 
+         _callback_wheel_node< _timing, slots, levels, tick_us > 
+      >
+   {
+   private:
+   
+      HARDWARE_REQUIRE_ARCHETYPE( _timing, has_timing ); 
+      
+   public:
+   
+      static void update( const typename _timing::moment now ){
+         _callback_isr_queue< 
+            _timing, 
+            _callback_wheel_node< _timing, slots, levels, tick_us > 
+         >::drain();
+         _callback_wheel_node< _timing, slots, levels, tick_us >
+            ::update( now );
+      }
+      
+      static typename _timing::moment next_deadline( 
+         const typename _timing::moment limit 
+      ){
+         _callback_isr_queue< 
+            _timing, 
+            _callback_wheel_node< _timing, slots, levels, tick_us > 
+         >::drain();
+         return _callback_wheel_node< _timing, slots, levels, tick_us >
+            ::next_deadline( limit );
+      }
+      
+      // a start_from_isr() that next_deadline() has not seen
+      static bool isr_pending(){
+         return _callback_isr_queue< 
+            _timing, 
+            _callback_wheel_node< _timing, slots, levels, tick_us > 
+         >::pending();
+      }
+      
+   }; // class callback_administration_wheel
+   
+   // the timing wheel with its default parameters, 
+   // for use as callback_administration
+   template< class _timing >
+   using callback_administration_timing_wheel = 
+      callback_administration_wheel< _timing >;
+   
+   
    // =======================================================================
    //
    // the administration-independent part of the callback implementation,
    // provides:
    // - maintaining the lock_counter by creating and descruting lock objects
    // - serving the callback chain while doing a one-parameter wait
+   // - serving it until margin before the end of a two-parameter wait,
+   //   and waiting without it for the rest, so a callback that starts
+   //   before that point and takes less than margin does not make 
+   //   the wait late
    //
    // =======================================================================
 
@@ -740,10 +1976,25 @@ namespace hwcpp {
       	   if( now >= m ){
       	      return;
       	   }
+      	   moment deadline = m;
+      	   bool (*pending)() = nullptr;
       	   if( lock_counter == 0 ){
       	      typename callback_activation::lock block_recusion;
       	      callback_administration< service >::update( now );   
+      	      deadline = 
+      	         callback_administration< service >::next_deadline( m );
+      	      
+      	      // a callback is due one tick after its epoch
+      	      if( deadline < m ){
+      	         deadline += duration( 1 );
+      	      }
+      	      
+      	      // a timer started from an interrupt after the drain 
+      	      // in next_deadline() prevents the sleep
+      	      pending = callback_administration< service >::isr_pending;
       	   }   
+      	   idle< implementation >::until( 
+      	      now.raw(), deadline.raw(), pending );
          }     
       }
       
@@ -752,10 +2003,13 @@ namespace hwcpp {
       }      
       
       static void wait( const duration d, const duration margin ){
-         service::wait( d );
+         wait( service::now() + d, margin );
       } 
       
       static void wait( const moment m, const duration margin ){
+         if( m - service::now() > margin ){
+            wait( m + ( - margin ));
+         }
          service::wait( m );
       } 
       
@@ -0,0 +1,519 @@
+// ==========================================================================
+//
+// File      : host_sim.hpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#include "hwcpp.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+// ==========================================================================
+//
+// host simulation target
+//
+// This target runs on the (Linux or Windows) host. The pins are backed
+// by an in-memory register file, which counts the reads and writes,
+// so code that uses pins and ports can be tested and benchmarked
+// without hardware.
+//
+// The timing service uses a virtual clock: a wait() advances the
+// virtual time instantly to the end of the wait, and each now()
+// advances it by one tick. With real_time = true the clock follows
+// the host's steady clock, and a wait() spins until the real time
+// has passed, after sleeping until shortly before that moment.
+// The virtual_timing service (simulation) advances its time only by
+// the waits, and services the callbacks in exact deadline order.
+//
+// Simulated peripherals (a shift register, an I2C slave, an LCD, ...)
+// are objects of a class derived from host_sim_peripheral. Their
+// update() is called after each write to a simulated register and
+// after each advance of the virtual time. A peripheral reads the
+// pins with level() and drives them with drive().
+//
+// ==========================================================================
+
+namespace hwcpp {
+
+   //========================================================================
+   //
+   // a simulated peripheral
+   //
+   //========================================================================
+
+   class host_sim_peripheral :
+      public noncopyable
+   {
+   private:
+
+      host_sim_peripheral * next;
+
+      static host_sim_peripheral *& root(){
+         static host_sim_peripheral * _root = nullptr;
+         return _root;
+      }
+
+   public:
+
+      // attach this peripheral to the simulation
+      host_sim_peripheral(): next( root() ){
+         root() = this;
+      }
+
+      // detach this peripheral from the simulation
+      virtual ~host_sim_peripheral(){
+         for(
+            host_sim_peripheral ** p = &root();
+            *p != nullptr;
+            p = &( *p )->next
+         ){
+            if( *p == this ){
+               *p = next;
+               return;
+            }
+         }
+      }
+
+      // called after the pins or the time have changed
+      virtual void update(){}
+
+      // call update() of all attached peripherals
+      static void update_all(){
+         static bool busy = false;
+         if( busy ){
+            return;
+         }
+         busy = true;
+         for( host_sim_peripheral * p = root(); p != nullptr; p = p->next ){
+            p->update();
+         }
+         busy = false;
+      }
+   };
+
+
+   //========================================================================
+   //
+   // a simulated port register
+   //
+   //========================================================================
+
+   template< int port >
+   struct host_sim_register :
+      public port_register_archetype
+   {
+      // the output level of the pins
+      static unsigned int value;
+
+      // the direction of the pins, a 1 bit is an output
+      static unsigned int direction;
+
+      // the level of the pins that are not outputs, as driven
+      // by the peripherals, by default pulled up
+      static unsigned int input;
+
+      // the number of get() and set_masked() calls
+      static unsigned int n_reads;
+      static unsigned int n_writes;
+
+      // the level of the pins
+      static unsigned int levels(){
+         return ( value & direction ) | ( input & ~ direction );
+      }
+
+      static bool level( int pin ){
+         return ( levels() >> pin ) & 0x01;
+      }
+
+      // drive a pin from outside (from a peripheral)
+      static void drive( int pin, bool x ){
+         input = x
+            ? ( input | ( 0x01U << pin ))
+            : ( input & ~ ( 0x01U << pin ));
+      }
+
+      static unsigned int get(){
+         n_reads++;
+         return levels();
+      }
+
+      static void set_masked( unsigned int mask, unsigned int x ){
+         n_writes++;
+         value = ( value & ~ mask ) | ( x & mask );
+         host_sim_peripheral::update_all();
+      }
+
+      static void direction_set( unsigned int mask, unsigned int x ){
+         direction = ( direction & ~ mask ) | ( x & mask );
+         host_sim_peripheral::update_all();
+      }
+
+      static void counters_clear(){
+         n_reads = 0;
+         n_writes = 0;
+      }
+   };
+
+   template< int port > unsigned int host_sim_register< port >::value;
+   template< int port > unsigned int host_sim_register< port >::direction;
+   template< int port > unsigned int host_sim_register< port >::input
+      = ~ 0U;
+   template< int port > unsigned int host_sim_register< port >::n_reads;
+   template< int port > unsigned int host_sim_register< port >::n_writes;
+
+
+   //========================================================================
+   //
+   // an input-output pin in a simulated port register
+   //
+   //========================================================================
+
+   template< int port, int pin >
+   struct host_sim_pin_in_out :
+      public pin_in_out_archetype,
+      public pin_port_register_archetype< host_sim_register< port >, pin >
+   {
+      static_assert(
+         ( pin >= 0 ) && ( pin < 32 ),
+         "host_sim pin number must be 0..31"
+      );
+
+      typedef host_sim_register< port > reg;
+
+      static void init(){}
+
+      static void direction_set_input(){
+         reg::direction_set( 0x01U << pin, 0 );
+      }
+
+      static void direction_set_output(){
+         reg::direction_set( 0x01U << pin, ~ 0U );
+      }
+
+      static void set( bool x ){
+         reg::set_masked( 0x01U << pin, x ? ~ 0U : 0U );
+      }
+
+      static bool get(){
+         return ( reg::get() >> pin ) & 0x01;
+      }
+   };
+
+
+   //========================================================================
+   //
+   // an open-collector pin in a simulated port register
+   //
+   // A 0 is written by making the pin an output with a 0 level,
+   // a 1 by making it an input, so it is pulled up unless a
+   // peripheral drives it low.
+   //
+   //========================================================================
+
+   template< int port, int pin >
+   struct host_sim_pin_oc :
+      public pin_oc_archetype
+   {
+      static_assert(
+         ( pin >= 0 ) && ( pin < 32 ),
+         "host_sim pin number must be 0..31"
+      );
+
+      typedef host_sim_register< port > reg;
+
+      static void init(){
+         reg::value &= ~ ( 0x01U << pin );
+         reg::direction_set( 0x01U << pin, 0 );
+      }
+
+      static void set( bool x ){
+         reg::n_writes++;
+         reg::direction_set( 0x01U << pin, x ? 0U : ~ 0U );
+      }
+
+      static bool get(){
+         return ( reg::get() >> pin ) & 0x01;
+      }
+   };
+
+
+   //========================================================================
+   //
+   // a simulated channel
+   //
+   // The chars put to the channel are appended to output, get() takes
+   // the chars from input. Nothing appends to input while get() waits, 
+   // so a get() or get_n() that would block (see get_will_block()) 
+   // is an error in the simulation: it stops the program.
+   //
+   //========================================================================
+
+   template< int id >
+   struct host_sim_channel :
+      public channel_in_out_archetype
+   {
+      static std::string output;
+      static std::string input;
+
+      static void init(){}
+
+      static bool put_will_block(){
+         return false;
+      }
+
+      static void put( char c ){
+         output.push_back( c );
+      }
+
+      typedef void has_put_n;
+      static void put_n( const char * s, unsigned int n ){
+         output.append( s, n );
+      }
+
+      static bool get_will_block(){
+         return input.empty();
+      }
+
+      static void fail_when_short( unsigned int n ){
+         if( input.size() < n ){
+            std::cerr 
+               << "host_sim_channel: get of " << n 
+               << " chars, input has " << input.size() << "\n";
+            exit( -1 );
+         }
+      }
+
+      static char get(){
+         fail_when_short( 1 );
+         char c = input[ 0 ];
+         input.erase( 0, 1 );
+         return c;
+      }
+
+      typedef void has_get_n;
+      static void get_n( char * s, unsigned int n ){
+         fail_when_short( n );
+         input.copy( s, n );
+         input.erase( 0, n );
+      }
+   };
+
+   template< int id > std::string host_sim_channel< id >::output;
+   template< int id > std::string host_sim_channel< id >::input;
+
+
+   //========================================================================
+   //
+   // the simulated clock
+   //
+   //========================================================================
+
+   template< bool real_time >
+   struct host_sim_clock :
+      public timing_support< long long int, 1000 >
+   {
+      // the virtual time, in ns
+      static base virtual_now;
+
+      static void init(){}
+
+      static base now(){
+         if( real_time ){
+            static const std::chrono::steady_clock::time_point start =
+               std::chrono::steady_clock::now();
+            return std::chrono::duration_cast< std::chrono::nanoseconds >(
+               std::chrono::steady_clock::now() - start ).count();
+         }
+         return virtual_now++;
+      }
+
+      static void advance_to( base t ){
+         if( real_time ){
+         
+            // sleep until the margin before t, spin for the rest
+            idle_until( t - idle_margin );
+            while( now() < t );
+            return;
+         }
+         if( t > virtual_now ){
+            virtual_now = t;
+            host_sim_peripheral::update_all();
+         }
+      }
+      
+      // a wait sleeps (or jumps) until shortly before its deadline,
+      // unless pending() is true; a thread that stands in for an 
+      // interrupt handler can not be masked and does not end a sleep,
+      // so in real time pending() is checked every idle_margin
+      typedef void has_idle_until;
+      static constexpr base idle_margin = real_time ? 100 * 1000 : 0;
+      
+      static void idle_until( base t, bool (*pending)() = nullptr ){
+         if( real_time ){
+            for(;;){
+               base n = now();
+               if(( t <= n ) || (( pending != nullptr ) && pending() )){
+                  return;
+               }
+               base d = t - n;
+               if(( pending != nullptr ) && ( d > idle_margin )){
+                  d = idle_margin;
+               }
+               std::this_thread::sleep_for( std::chrono::nanoseconds( d ));
+            }
+         }
+         if(( pending != nullptr ) && pending() ){
+            return;
+         }
+         advance_to( t );
+      }
+   };
+
+   template< bool real_time >
+      typename host_sim_clock< real_time >::base
+         host_sim_clock< real_time >::virtual_now;
+
+   // timing_waiter, but a wait() advances the simulated clock
+   template< class clock >
+   struct host_sim_waiter :
+      public timing_waiter< clock >
+   {
+      typedef void has_waiting_support;
+
+      typedef typename timing_waiter< clock >::moment moment;
+      typedef typename timing_waiter< clock >::duration duration;
+      typedef timing_waiter< clock > waiter;
+
+      static void wait( const moment t ){
+         clock::advance_to( t.raw() );
+      }
+
+      static void wait( const duration d ){
+         wait( waiter::now() + d );
+      }
+
+      static void wait( const moment t, const duration margin ){
+         wait( t );
+      }
+
+      static void wait( const duration d, const duration margin ){
+         wait( d );
+      }
+   };
+
+
+   //========================================================================
+   //
+   // the deterministic virtual-time timing service
+   //
+   // now() returns a counter (in ns) that only a wait() advances: it
+   // jumps instantly to the end of the wait, or to the next callback
+   // deadline, so hours of device behaviour are simulated in a fraction
+   // of that in CPU time, with the same results for each run. The
+   // callbacks are serviced in exact deadline order (by default by the
+   // pairing heap administration), each one tick after its epoch.
+   //
+   // Code that polls now() without waiting never sees the time pass.
+   //
+   //========================================================================
+
+   struct virtual_clock :
+      public timing_support< long long int, 1000 >
+   {
+      static base & ticks(){
+         static base _ticks = 0;
+         return _ticks;
+      }
+
+      static void init(){}
+
+      static base now(){
+         return ticks();
+      }
+
+      // a wait jumps to its deadline, unless pending() is true
+      typedef void has_idle_until;
+      static constexpr base idle_margin = 0;
+
+      static void idle_until( base t, bool (*pending)() = nullptr ){
+         if(( pending != nullptr ) && pending() ){
+            return;
+         }
+         if( t > ticks() ){
+            ticks() = t;
+            host_sim_peripheral::update_all();
+         }
+      }
+   };
+
+   template<
+      template< typename _timing > class callback_administration
+         = callback_administration_pairing_heap
+   >
+   struct virtual_timing :
+      public callback_implementation<
+         virtual_clock,
+         callback_administration
+      >
+   {
+      typedef void has_waiting_support;
+   };
+
+
+   //========================================================================
+   //
+   // the target
+   //
+   //========================================================================
+
+   template<
+      unsigned int frequency = 100 * MHz,
+      bool real_time = false
+   >
+   struct host_sim :
+      public target_archetype< 64 * Mib, 64 * Mib, frequency >
+   {
+      template< int port, int pin >
+      struct pin_in_out : public host_sim_pin_in_out< port, pin >{};
+
+      template< int port, int pin >
+      struct pin_oc : public host_sim_pin_oc< port, pin >{};
+
+      template< int port >
+      struct port_register : public host_sim_register< port >{};
+
+      template< int id = 0 >
+      struct channel : public host_sim_channel< id >{};
+
+      typedef host_sim_clock< real_time > clock;
+
+      typedef add_timing_templates<
+         host_sim_waiter< clock >
+      > waiting;
+
+      typedef add_timing_templates<
+         host_sim_waiter< clock >
+      > timing;
+
+      // the callbacks are serviced while the wait polls now(),
+      // which advances the virtual time one tick per call
+      typedef callback_implementation<
+         clock
+      > callback;
+
+      // the virtual time advances only by waits
+      typedef virtual_timing<> simulation;
+   };
+
+}; // namespace hwcpp
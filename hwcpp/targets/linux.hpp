@@ -0,0 +1,159 @@
+// ==========================================================================
+//
+// File      : linux.hpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#include "hwcpp.hpp"
+
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+
+
+// ==========================================================================
+//
+// Linux timing support
+//
+// linux_clock is a timing_support that counts ns from a Linux clock,
+// by default CLOCK_MONOTONIC_RAW, which (unlike CLOCK_REALTIME) does
+// not jump when the time is set, and (unlike CLOCK_MONOTONIC) is not
+// slewed by NTP. The C library reads both through the vDSO, without
+// a system call.
+//
+// A wait sleeps (clock_nanosleep) until margin_us before its deadline,
+// and spins for the rest. The margin must cover the wake-up latency
+// of the system: with a margin that is too small a wait returns late,
+// with one that is too large it wastes CPU time. When
+// HWCPP_IDLE_STATISTICS is defined as 1 the lateness of each wake-up
+// is recorded in 1 us steps, and wakeup_late_percentile( p ) returns
+// the lateness (in ns) that p percent of the wake-ups did not exceed,
+// so the margin can be chosen as for instance the 99 percentile:
+//
+//    typedef timing_implementation< linux_clock<> > timing;
+//    ...
+//    io::cout << linux_clock<>::wakeup_late_percentile( 99 ) << "\n";
+//
+// For microsecond-accurate bit-banging, run the program with a
+// real-time priority (chrt -f 50 ...) to get a small and stable
+// wake-up latency.
+//
+// ==========================================================================
+
+namespace hwcpp {
+
+   template<
+      unsigned int margin_us = 100,
+      clockid_t clock_id = CLOCK_MONOTONIC_RAW
+   >
+   struct linux_clock :
+      public timing_support< long long int, 1000 >
+   {
+      static void init(){}
+
+      static base now(){
+         struct timespec t;
+         clock_gettime( clock_id, &t );
+         return ( (base) t.tv_sec * 1000000000LL ) + t.tv_nsec;
+      }
+
+      typedef void has_idle_until;
+      static constexpr base idle_margin = margin_us * 1000LL;
+
+      // clock_nanosleep can not use CLOCK_MONOTONIC_RAW, so for that
+      // clock it sleeps for the remaining time on CLOCK_MONOTONIC
+      //
+      // With pending, the signals are blocked while it is checked,
+      // and ppoll() sleeps with them unblocked again, so a signal 
+      // handler that makes pending() true after the check ends the 
+      // sleep. A thread that does so is not seen until the wakeup.
+      static void idle_until( base t, bool (*pending)() = nullptr ){
+         base n = now();
+         if( t <= n ){
+            return;
+         }
+         struct timespec s;
+         if( pending != nullptr ){
+            sigset_t all, old;
+            sigfillset( &all );
+            pthread_sigmask( SIG_SETMASK, &all, &old );
+            if( ! pending() ){
+               n = now();
+               if( t > n ){
+                  s.tv_sec = ( t - n ) / 1000000000LL;
+                  s.tv_nsec = ( t - n ) % 1000000000LL;
+                  ppoll( nullptr, 0, &s, &old );
+               }
+            }
+            pthread_sigmask( SIG_SETMASK, &old, nullptr );
+         } else if( clock_id == CLOCK_MONOTONIC ){
+            s.tv_sec = t / 1000000000LL;
+            s.tv_nsec = t % 1000000000LL;
+            clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &s, nullptr );
+         } else {
+            s.tv_sec = ( t - n ) / 1000000000LL;
+            s.tv_nsec = ( t - n ) % 1000000000LL;
+
+            // a signal ends the sleep early, which is allowed
+            clock_nanosleep( CLOCK_MONOTONIC, 0, &s, nullptr );
+         }
+         #if HWCPP_IDLE_STATISTICS
+            wakeup_record( now() - t );
+         #endif
+      }
+
+      #if HWCPP_IDLE_STATISTICS
+
+         // the number of wake-ups that were 0..1 us late, 1..2 us, etc.,
+         // the last entry counts all that were later
+         static constexpr unsigned int wakeup_steps = 1000;
+         static unsigned int wakeup_late[ wakeup_steps ];
+
+         static void wakeup_record( base late ){
+            base step = ( late <= 0 ) ? 0 : late / 1000;
+            if( step >= wakeup_steps ){
+               step = wakeup_steps - 1;
+            }
+            wakeup_late[ step ]++;
+         }
+
+         // the lateness in ns that percent % of the wake-ups did not
+         // exceed, rounded up to a whole us
+         static base wakeup_late_percentile( unsigned int percent ){
+            unsigned long long total = 0;
+            for( unsigned int i = 0; i < wakeup_steps; i++ ){
+               total += wakeup_late[ i ];
+            }
+            unsigned long long count = 0;
+            for( unsigned int i = 0; i < wakeup_steps; i++ ){
+               count += wakeup_late[ i ];
+               if( 100 * count >= percent * total ){
+                  return ( i + 1 ) * 1000LL;
+               }
+            }
+            return wakeup_steps * 1000LL;
+         }
+
+         static void wakeup_clear(){
+            for( unsigned int i = 0; i < wakeup_steps; i++ ){
+               wakeup_late[ i ] = 0;
+            }
+         }
+
+      #endif
+   };
+
+   #if HWCPP_IDLE_STATISTICS
+      template< unsigned int m, clockid_t c >
+         unsigned int linux_clock< m, c >::wakeup_late[
+            linux_clock< m, c >::wakeup_steps ];
+   #endif
+
+}; // namespace hwcpp
@@ -13,6 +13,7 @@
 #include <ostream>
 #include "hwcpp.hpp"
 #include "LPC11xx.h"
+#include "lpc1114_uart.hpp"
 
 
 // ==========================================================================
@@ -246,6 +247,28 @@ protected:
       return *gpioreg( port, 0x3FFC ) & ( 0x01 << pin );  
    }
    
+   //========================================================================
+   //
+   // the GPIO DATA register of a port
+   //
+   // The address bits 13:2 are a mask: a write changes only the 
+   // pins that are 1 in the mask, so set_masked() is a single store.
+   //
+   //========================================================================
+   
+   template< int port >
+   struct gpio_register : 
+      public port_register_archetype 
+   {
+      static void set_masked( unsigned int mask, unsigned int value ){
+         *gpioreg( port, ( mask & 0x0FFF ) << 2 ) = value;
+      }
+      
+      static unsigned int get(){
+         return *gpioreg( port, 0x3FFC );
+      }
+   };
+   
    //========================================================================
    //
    // an open collector pin (no pullup or A/D )
@@ -285,7 +308,8 @@ protected:
    template< int port, int pin >
    struct pin_in_out_pullup :
       public pin_in_out_archetype,
-      public pin_configurable_pullup_archetype 
+      public pin_configurable_pullup_archetype,
+      public pin_port_register_archetype< gpio_register< port >, pin >
    {
       
       static void init(){
@@ -458,9 +482,20 @@ protected:
          } 
       }
            
+      //! the free places in the 16 char transmit FIFO
+      //
+      //! TXFIFOLVL (FIFOLVL bits 11:8) is 4 bits wide, it reads 0xF
+      //! when the FIFO is full, so 0xF is taken as no room.
+      static unsigned int tx_fifo_room(){
+         unsigned int level = ( LPC_UART->FIFOLVL >> 8 ) & 0x0F;
+         return ( level == 0x0F ) ? 0 : 16 - level;
+      }
+      
       //! report if the uart is ready to accpet a char
+      //
+      //! It is as long as its 16 char transmit FIFO is not full.
       static bool put_will_block(){
-         return ( LPC_UART->LSR & ( 1 << 6 )) == 0;
+         return tx_fifo_room() == 0;
       }
       
 	  //! put a char
@@ -468,10 +503,23 @@ protected:
 	  //! When the uart is no ready to accept a char this call will
 	  //! block untill it is.
       static void put( char c ){
-         while(( LPC_UART->LSR & ( 1 << 6 )) == 0 );
+         while( put_will_block() );
          LPC_UART->THR = c;
       }
       
+      //! put n chars, filling the transmit FIFO as far as it has room
+      typedef void has_put_n;
+      static void put_n( const char * s, unsigned int n ){
+         while( n > 0 ){
+            unsigned int room = tx_fifo_room();
+            while(( room > 0 ) && ( n > 0 )){
+               LPC_UART->THR = *s++;
+               room--;
+               n--;
+            }
+         }
+      }
+      
 	  //! report whether the uart is ready to accept a char
       static bool get_will_block(){
          return ( LPC_UART->LSR & 0x01 ) == 0;
@@ -487,6 +535,35 @@ protected:
       }   
       
    };
+   
+   // the address of the UART registers, for lpc1114_uart_buffered
+   struct uart_registers {
+      static LPC_UART_TypeDef * uart(){
+         return LPC_UART;
+      }
+   };
+   
+   //! interrupt-driven UART, see lpc1114_uart.hpp
+   template< 
+      unsigned int baudrate, 
+      unsigned int tx_size = 64, 
+      unsigned int rx_size = 32 
+   >
+   class uart_buffered :
+      public lpc1114_uart_buffered< uart_registers, tx_size, rx_size >
+   {
+      typedef lpc1114_uart_buffered< uart_registers, tx_size, rx_size > 
+         buffers;
+      
+   public:
+   
+      //! initialize the uart and enable its interrupt
+      static void init(){
+         uart< baudrate >::init();
+         buffers::init();
+         NVIC_EnableIRQ( UART_IRQn );
+      }
+   };
 
    
    //=====================================================================
@@ -495,13 +572,34 @@ protected:
    //
    //=====================================================================
    
+   // a busy loop of 4 cycles per loop, used for the short waits
+   struct busy_loop_4 {
+      typedef void has_busy_loop;
+      static constexpr unsigned long long busy_loop_frequency = 
+         clock_frequency;
+      static constexpr unsigned long long busy_loop_cycles = 4;
+      static constexpr unsigned long long busy_loop_overhead = 4;
+      
+      static void busy_loop( unsigned int n ){
+         asm volatile( 
+            "   mov r0, %[reg]   \t\n"
+            "   b   1f           \t\n"
+            "   .align 4         \t\n"
+            "1: sub r0, #1       \t\n" 
+            "   bgt 1b           \t\n" 
+            :: [reg] "r" (n) : "r0"
+         );
+      }
+   };
+   
    // uses the 24-bit SysTick, extended to 64 bits, gives ample range:
    // 2^63 Hz / 24 MHz => 12186 years
    struct timer_64 : 
       public timing_support< 
          long long int, 
          ( clock_frequency ) / ( 2 * MHz )          
-      > 
+      >,
+      public busy_loop_4
    {
    
       typedef long long int base;   
@@ -536,6 +634,67 @@ protected:
       } 
    };   
    
+   // timer_64 that sleeps (WFI) until CT32B0, counting at the SysTick 
+   // rate, reaches the deadline of a long wait. Opt-in, because it 
+   // reserves CT32B0: each such wait rewrites its PR, MR0, MCR and TCR, 
+   // so the application must not use CT32B0 itself. Interrupts are 
+   // disabled while asleep, so the match wakes the CPU without a 
+   // handler, and any other enabled interrupt ends the sleep early 
+   // and is handled after it. pending() is checked with the interrupts
+   // disabled, so an interrupt that makes it true after the check 
+   // is pending for the WFI, which then returns at once.
+   struct timer_64_idle : public timer_64 {
+   
+      typedef void has_idle_until;
+      static constexpr base idle_margin = 20 * timer_64::ticks_per_us;
+      
+      static void idle_until( base t, bool (*pending)() = nullptr ){
+         base n = now();
+         if( t <= n ){
+            return;
+         }
+         
+         // now() must be called at least once per SysTick rollover
+         base d = t - n;
+         if( d > 0x800000 ){
+            d = 0x800000;
+         }
+         
+         LPC_SYSCON->SYSAHBCLKCTRL |= ( 0x01 << 9 );  // enable CT32B0
+         LPC_TMR32B0->TCR = 0x02;                     // stop and reset
+         LPC_TMR32B0->PR  = 
+            ( clock_frequency / ( timer_64::ticks_per_us * MHz )) - 1;
+         LPC_TMR32B0->MR0 = d;
+         LPC_TMR32B0->MCR = 0x05;                     // interrupt, stop
+         LPC_TMR32B0->IR  = 0x1F;                     // clear the flags
+         NVIC_ClearPendingIRQ( TIMER_32_0_IRQn );
+         
+         // the match must reach the NVIC to wake the CPU, 
+         // leave the line as it was found
+         bool was_enabled = 
+            NVIC->ISER[ 0 ] & ( 0x01U << (unsigned int) TIMER_32_0_IRQn );
+         if( ! was_enabled ){
+            NVIC_EnableIRQ( TIMER_32_0_IRQn );
+         }
+         
+         unsigned int primask = __get_PRIMASK();
+         __disable_irq();
+         if(( pending == nullptr ) || ! pending() ){
+            LPC_TMR32B0->TCR = 0x01;                  // start
+            __WFI();
+         }
+         LPC_TMR32B0->TCR = 0x00;                     // stop
+         LPC_TMR32B0->IR  = 0x1F;
+         NVIC_ClearPendingIRQ( TIMER_32_0_IRQn );
+         if( ! was_enabled ){
+            NVIC_DisableIRQ( TIMER_32_0_IRQn );
+         }
+         if( primask == 0 ){
+            __enable_irq();
+         }
+      }
+   };   
+   
    // for test/demo only
    // 24 bits without extension is far too short to be practical:
    // 2^24 Hz / 6 MHz => 2.8 s !
@@ -569,7 +728,8 @@ protected:
       : public waiting_support < 
            unsigned int, 
            ( clock_frequency ) / ( 4 * MHz ) 
-        >
+        >,
+        public busy_loop_4
    {
       
       typedef unsigned int base;
@@ -579,14 +739,7 @@ protected:
       }
       
       static void wait( const base x ){
-         asm volatile( 
-            "   mov r0, %[reg]   \t\n"
-            "   b   1f           \t\n"
-            "   .align 4         \t\n"
-            "1: sub r0, #1       \t\n" 
-            "   bgt 1b           \t\n" 
-            :: [reg] "r" (x) : "r0"
-         );
+         busy_loop( x );
       }
        
    }; 
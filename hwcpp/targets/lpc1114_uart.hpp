@@ -0,0 +1,214 @@
+// ==========================================================================
+//
+// File      : lpc1114_uart.hpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+#include "hwcpp.hpp"
+
+
+// ==========================================================================
+//
+// interrupt-driven LPC1114 UART buffers
+//
+// put() writes to a transmit ring buffer, from which the characters
+// are moved to the 16 character hardware FIFO in bursts: by put()
+// itself when the FIFO has room, and by the THRE (FIFO empty)
+// interrupt. The receive interrupts move the received characters
+// from the hardware FIFO to a receive ring buffer, from which get()
+// reads them. A character that is received while the receive buffer
+// is full is lost and counted in rx_overruns, a character lost by
+// the hardware FIFO is counted in hw_overruns.
+//
+// The registers argument provides uart(), which returns the address
+// of the UART register block (LPC_UART), so the buffer and interrupt
+// logic can be tested on the host with a mock register block. The
+// application must call isr() from the UART interrupt handler:
+//
+//    extern "C" void UART_IRQHandler(){ target::uart_buffered<>::isr(); }
+//
+// ==========================================================================
+
+namespace hwcpp {
+
+   template<
+      class registers,
+      unsigned int tx_size = 64,
+      unsigned int rx_size = 32
+   >
+   class lpc1114_uart_buffered :
+      public channel_in_out_archetype
+   {
+      // line status register (LSR) bits
+      static const unsigned int LSR_RDR   = 0x01;
+      static const unsigned int LSR_OE    = 0x02;
+
+      // interrupt enable register (IER) bits
+      static const unsigned int IER_RBR   = 0x01;
+      static const unsigned int IER_THRE  = 0x02;
+      static const unsigned int IER_RLS   = 0x04;
+
+      // interrupt identification register (IIR) values
+      static const unsigned int IIR_NONE  = 0x01;
+      static const unsigned int IIR_RLS   = 0x06;
+      static const unsigned int IIR_RDA   = 0x04;
+      static const unsigned int IIR_CTI   = 0x0C;
+      static const unsigned int IIR_THRE  = 0x02;
+
+      static const unsigned int fifo_size = 16;
+
+      // tx is read by whichever moves characters to the hardware FIFO
+      // (with the THRE interrupt disabled when that is the main code)
+      static spsc_ring< char, tx_size > tx;
+      static spsc_ring< char, rx_size > rx;
+
+      // TXFIFOLVL (FIFOLVL bits 11:8) is 4 bits wide and reads 0xF
+      // when the FIFO is full, so 0xF is taken as no room
+      static unsigned int tx_fifo_room(){
+         unsigned int level = ( registers::uart()->FIFOLVL >> 8 ) & 0x0F;
+         return ( level == 0x0F ) ? 0 : fifo_size - level;
+      }
+
+      // move characters from the buffer to the hardware FIFO
+      static void fill(){
+         unsigned int n = tx_fifo_room();
+         while( n > 0 ){
+            char * p;
+            unsigned int m = tx.pop_span( p );
+            if( m == 0 ){
+               return;
+            }
+            if( m > n ){
+               m = n;
+            }
+            for( unsigned int i = 0; i < m; i++ ){
+               registers::uart()->THR = p[ i ];
+            }
+            tx.pop_commit( m );
+            n -= m;
+         }
+      }
+
+      // fill from the main code
+      static void kick(){
+         registers::uart()->IER = IER_RBR | IER_RLS;
+         fill();
+         registers::uart()->IER = IER_RBR | IER_THRE | IER_RLS;
+      }
+
+      // move characters from the hardware FIFO to the buffer
+      static void receive(){
+         for(;;){
+            unsigned int lsr = registers::uart()->LSR;
+            if( lsr & LSR_OE ){
+               hw_overruns++;
+            }
+            if(( lsr & LSR_RDR ) == 0 ){
+               return;
+            }
+            if( ! rx.push( registers::uart()->RBR )){
+               rx_overruns++;
+            }
+         }
+      }
+
+   public:
+
+      // the number of characters lost because the receive buffer
+      // or the hardware receive FIFO was full
+      static volatile unsigned int rx_overruns;
+      static volatile unsigned int hw_overruns;
+
+      // empty the buffers and enable the interrupts, the UART
+      // itself (pins, baudrate, line format) must be initialized
+      static void init(){
+         tx.clear();
+         rx.clear();
+         rx_overruns = 0;
+         hw_overruns = 0;
+
+         // FIFOs enabled and reset, receive interrupt at 8 characters
+         registers::uart()->FCR = 0x87;
+         registers::uart()->IER = IER_RBR | IER_THRE | IER_RLS;
+      }
+
+      static bool put_will_block(){
+         return tx.full();
+      }
+
+      //! put a char
+      //
+      //! When the buffer is full this call will block until it is not.
+      static void put( char c ){
+         while( put_will_block() ){
+            kick();
+         }
+         tx.push( c );
+         kick();
+      }
+      
+      typedef void has_put_n;
+      static void put_n( const char * s, unsigned int n ){
+         while( n > 0 ){
+            unsigned int m = tx.push_n( s, n );
+            s += m;
+            n -= m;
+            kick();
+         }
+      }
+
+      static bool get_will_block(){
+         return rx.empty();
+      }
+
+      //! return a received char
+      //
+      //! When the buffer is empty this call will block until it is not.
+      static char get(){
+         char c;
+         while( ! rx.pop( c ) ){}
+         return c;
+      }
+      
+      typedef void has_get_n;
+      static void get_n( char * s, unsigned int n ){
+         while( n > 0 ){
+            unsigned int m = rx.pop_n( s, n );
+            s += m;
+            n -= m;
+         }
+      }
+
+      // the UART interrupt handler
+      static void isr(){
+         for(;;){
+            unsigned int iir = registers::uart()->IIR & 0x0F;
+            if( iir & IIR_NONE ){
+               return;
+            }
+            if( iir == IIR_THRE ){
+               fill();
+            } else {
+               // IIR_RLS, IIR_RDA or IIR_CTI
+               receive();
+            }
+         }
+      }
+   };
+
+   template< class r, unsigned int t, unsigned int s >
+      spsc_ring< char, t > lpc1114_uart_buffered< r, t, s >::tx;
+   template< class r, unsigned int t, unsigned int s >
+      spsc_ring< char, s > lpc1114_uart_buffered< r, t, s >::rx;
+   template< class r, unsigned int t, unsigned int s >
+      volatile unsigned int lpc1114_uart_buffered< r, t, s >::rx_overruns;
+   template< class r, unsigned int t, unsigned int s >
+      volatile unsigned int lpc1114_uart_buffered< r, t, s >::hw_overruns;
+
+}; // namespace hwcpp
@@ -52,8 +52,26 @@ struct lpc1114fn28 : public lpc1114_base< 4 * Kib, 32 * Kib, frequency > {
       typename t::timer_64 
    > callback;
    
+   // opt-in: long waits sleep (WFI) instead of busy-waiting,
+   // this reserves CT32B0, so the application must not use it
+   typedef timing_implementation< 
+      typename t::timer_64_idle 
+   > timing_idle;
+   
+   typedef callback_implementation<
+      typename t::timer_64_idle 
+   > callback_idle;
+   
    template< unsigned int baudrate = HWCPP_BAUDRATE >
    class uart : public t::template uart< baudrate >{};
+   
+   template< 
+      unsigned int baudrate = HWCPP_BAUDRATE,
+      unsigned int tx_size = 64, 
+      unsigned int rx_size = 32 
+   >
+   class uart_buffered : 
+      public t::template uart_buffered< baudrate, tx_size, rx_size >{};
 };
 
 }; // namespace hwcpp
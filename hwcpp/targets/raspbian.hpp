@@ -1,6 +1,7 @@
 #include <ostream>
 
 #include "hwcpp.hpp"
+#include "linux.hpp"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -124,28 +125,6 @@ private:
 
    };
 
-   //=====================================================================
-   //
-   // timing
-   //
-   //=====================================================================
-   
-   struct time_base_64 {
-      typedef long long int base;
-
-      static constexpr base ticks_per_us = 1;
-   
-      static base current_time(){
-         struct timespec now;
-         clock_gettime( CLOCK_REALTIME, &now);
-         return 
-         ( now.tv_sec * 1000000L ) + ( now.tv_nsec / 1000L )    
-;
-      } 
-   };   
-   
-
-   
 public: 
 
    //========================================================================
@@ -173,7 +152,10 @@ public:
    typedef rapi_pin_in_out<    7    > gp07;
 
    
-   typedef timing_template< time_base_64 > timing;
+   // the Pi's wake-up latency is larger than a PC's
+   typedef hwcpp::timing_implementation< 
+      hwcpp::linux_clock< 200 > 
+   > timing;
    
 };
 
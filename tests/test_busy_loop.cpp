@@ -0,0 +1,120 @@
+// ==========================================================================
+//
+// File      : test_busy_loop.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// short compile-time waits use the calibrated busy loop with the
+// smallest loop count that is long enough, longer waits use the
+// timing service
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+// a 1 GHz timing support with a 48 MHz busy loop of 4 cycles per loop
+// and 4 cycles overhead, like the LPC1114 one, that records its use
+struct recorder : timing_support< long long int, 1000 > {
+   static long long ticks;
+   static unsigned int loops, n_calls;
+   static void init(){}
+   static base now(){ return ticks += 1; }
+
+   typedef void has_busy_loop;
+   static constexpr unsigned long long busy_loop_frequency = 48 * MHz;
+   static constexpr unsigned long long busy_loop_cycles = 4;
+   static constexpr unsigned long long busy_loop_overhead = 4;
+   static void busy_loop( unsigned int n ){
+      loops = n;
+      n_calls++;
+   }
+};
+long long recorder::ticks;
+unsigned int recorder::loops, recorder::n_calls;
+
+typedef timing_implementation< recorder > timing;
+typedef callback_implementation< recorder > callbacks;
+
+// the loop count for d ns is long enough, and one loop less is not
+template< class service, unsigned long long d >
+void check_calibration(){
+   recorder::n_calls = 0;
+   recorder::loops = 0;
+   long long t0 = recorder::ticks;
+   service::template ns< d >::wait();
+   HWCPP_ASSERT( recorder::ticks == t0 );
+   unsigned long long needed = ( d * 48 + 999 ) / 1000;
+   unsigned long long n = recorder::loops;
+   if( needed <= 4 ){
+      HWCPP_ASSERT( recorder::n_calls == 0 );
+   } else {
+      HWCPP_ASSERT( recorder::n_calls == 1 );
+      HWCPP_ASSERT( 4 + n * 4 >= needed );
+      HWCPP_ASSERT( 4 + ( n - 1 ) * 4 < needed );
+   }
+}
+
+template< class service >
+void check( const char * name ){
+   test t( name );
+   check_calibration< service, 0 >();
+   check_calibration< service, 50 >();
+   check_calibration< service, 100 >();
+   check_calibration< service, 1000 >();
+   check_calibration< service, 12345 >();
+   check_calibration< service, HWCPP_BUSY_WAIT_NS >();
+
+   // us<> waits the same number of ns
+   service::template us< 10 >::wait();
+   HWCPP_ASSERT( recorder::loops == ( 10000 * 48 / 1000 - 4 ) / 4 );
+
+   // a longer wait uses the service
+   recorder::n_calls = 0;
+   long long t0 = recorder::ticks;
+   service::template ms< 1 >::wait();
+   HWCPP_ASSERT( recorder::n_calls == 0 );
+   HWCPP_ASSERT( recorder::ticks - t0 >= 1000000 );
+}
+
+int main(){
+   test all( "busy loop" );
+
+   check< timing >( "timing" );
+   check< callbacks >( "callback" );
+
+   {
+      // no margin stays no margin when scaled, a margin is scaled
+      test t( "margins" );
+      HWCPP_ASSERT( timing::ns< 5 >::margin == timing::infinite );
+      HWCPP_ASSERT( timing::ms< 1 >::margin == timing::infinite );
+      HWCPP_ASSERT( timing::day< 1 >::margin == timing::infinite );
+      HWCPP_ASSERT(( timing::us< 10, 2 >::margin == 2000 ));
+      HWCPP_ASSERT(( timing::ms< 10, 2 >::margin == 2000000 ));
+      HWCPP_ASSERT(( timing::s< 1, 1ULL << 62 >::margin == timing::infinite ));
+   }
+
+   {
+      test t( "periods" );
+      HWCPP_ASSERT( timing::kHz< 100 >::half_period::_duration == 5000 );
+      HWCPP_ASSERT( timing::kHz< 100 >::period::_duration == 10000 );
+      HWCPP_ASSERT( timing::kHz< 400 >::half_period::_duration == 1250 );
+   }
+
+   {
+      test t( "host_sim waits are exact" );
+      typedef host_sim<>::timing sim;
+      long long t0 = sim::now().raw();
+      sim::kHz< 400 >::half_period::wait();
+      HWCPP_ASSERT( sim::now().raw() - t0 == 1250 + 1 );
+      t0 = sim::now().raw();
+      sim::ns< 0 >::wait();
+      HWCPP_ASSERT( sim::now().raw() - t0 == 1 );
+   }
+}
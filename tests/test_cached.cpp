@@ -0,0 +1,92 @@
+// ==========================================================================
+//
+// File      : test_cached.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// cached<> skips the writes of an unchanged value to a pin or port,
+// and force_flush() writes the remembered value again
+
+#define HWCPP_CACHED_STATISTICS 1
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+typedef host_sim_register< 2 > r2;
+
+typedef cached< host_sim_pin_in_out< 0, 0 >> pin;
+typedef cached< port_out_from_pins<
+   host_sim_pin_in_out< 1, 0 >,
+   host_sim_pin_in_out< 1, 1 >
+>> port;
+typedef cached< host_sim_pin_oc< 2, 0 >> oc;
+
+int main(){
+   test all( "cached" );
+
+   {
+      test t( "pin" );
+      pin::init();
+      pin::direction_set_output();
+      r0::counters_clear();
+      pin::set( 1 );
+      pin::set( 1 );
+      pin::set( 0 );
+      HWCPP_ASSERT( r0::n_writes == 2 );
+      HWCPP_ASSERT( pin::shadow::hits == 1 );
+      HWCPP_ASSERT( pin::shadow::misses == 2 );
+      HWCPP_ASSERT( pin::get() == 0 );
+
+      // the pin was changed behind the cache, a flush restores it
+      r0::value = 1;
+      pin::force_flush();
+      HWCPP_ASSERT( r0::n_writes == 3 );
+      HWCPP_ASSERT( pin::get() == 0 );
+   }
+
+   {
+      test t( "port" );
+      port::init();
+      r1::counters_clear();
+      port::set( 2 );
+      port::set( 2 );
+      port::set( 2 );
+      HWCPP_ASSERT( port::shadow::hits == 2 );
+      HWCPP_ASSERT( port::shadow::misses == 1 );
+      HWCPP_ASSERT(( r1::value & 3 ) == 2 );
+      unsigned int writes = r1::n_writes;
+      port::set( 1 );
+      HWCPP_ASSERT( r1::n_writes > writes );
+      HWCPP_ASSERT(( r1::value & 3 ) == 1 );
+   }
+
+   {
+      test t( "init forgets the value" );
+      pin::init();
+      r0::counters_clear();
+      pin::set( 0 );
+      HWCPP_ASSERT( r0::n_writes == 1 );
+      HWCPP_ASSERT( pin::shadow::misses == 1 );
+   }
+
+   {
+      test t( "open-collector pin" );
+      oc::init();
+      r2::counters_clear();
+      oc::set( 0 );
+      oc::set( 0 );
+      HWCPP_ASSERT( oc::shadow::hits == 1 );
+      HWCPP_ASSERT( oc::get() == 0 );
+      oc::set( 1 );
+      HWCPP_ASSERT( oc::get() == 1 );
+   }
+}
@@ -0,0 +1,75 @@
+// ==========================================================================
+//
+// File      : test_callback_statistics.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// with HWCPP_CALLBACK_STATISTICS each timer and clock counts its
+// activations, lateness and run time
+
+#define HWCPP_CALLBACK_STATISTICS 1
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <sstream>
+#include <string>
+
+using namespace hwcpp;
+
+typedef host_sim<>::callback timing;
+
+// a 100 us clock whose function() takes 3 us
+struct slow_clock : timing::clock<> {
+   slow_clock(): timing::clock<>( timing::duration::us( 100 )){}
+   void function() override {
+      timing::wait( timing::duration::us( 3 ));
+   }
+};
+
+struct timer : timing::timer<> {
+   void function() override {}
+};
+
+int main(){
+   test all( "callback statistics" );
+
+   slow_clock c;
+   timer once;
+   HWCPP_ASSERT( once.statistics().activations == 0 );
+   once.start( timing::duration::us( 50 ));
+   timing::wait( timing::duration::ms( 2 ));
+
+   {
+      test t( "activations" );
+      HWCPP_ASSERT( c.statistics().activations == 20 );
+      HWCPP_ASSERT( once.statistics().activations == 1 );
+   }
+
+   {
+      test t( "lateness and run time" );
+      auto & s = c.statistics();
+      HWCPP_ASSERT( s.late_min.raw() >= 0 );
+      HWCPP_ASSERT( s.late_min <= s.late_mean() );
+      HWCPP_ASSERT( s.late_mean() <= s.late_max );
+      HWCPP_ASSERT( s.late_max < timing::duration::us( 1 ));
+      HWCPP_ASSERT( s.run_max >= timing::duration::us( 3 ));
+      HWCPP_ASSERT( s.run_max < timing::duration::us( 4 ));
+      HWCPP_ASSERT( once.statistics().run_max < timing::duration::us( 1 ));
+   }
+
+   {
+      test t( "printing" );
+      std::ostringstream s;
+      s << c.statistics();
+      HWCPP_ASSERT( s.str() == "n=20 late us min=0 mean=0 max=0 run us max=3" );
+      c.statistics_clear();
+      std::ostringstream e;
+      e << c.statistics();
+      HWCPP_ASSERT( e.str() == "n=0" );
+   }
+}
@@ -0,0 +1,133 @@
+// ==========================================================================
+//
+// File      : test_channel_blocks.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// block transfers: channel_put_n<> and channel_get_n<> with and
+// without a block version, io::ostream through put_n (same output,
+// and its speed compared to char by char), and a host_sim_channel
+// get() from empty input stops the program instead of hanging
+
+#define BMPTK_EMBEDDED_IOSTREAM
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace hwcpp;
+
+typedef host_sim<>::channel<> channel;
+
+// a channel without block versions
+struct plain : channel_in_out_archetype {
+   static std::string output, input;
+   static void init(){}
+   static bool put_will_block(){ return false; }
+   static void put( char c ){ output += c; }
+   static bool get_will_block(){ return input.empty(); }
+   static char get(){
+      char c = input[ 0 ];
+      input.erase( 0, 1 );
+      return c;
+   }
+};
+std::string plain::output, plain::input;
+
+// chars per second
+double format( io::ostream & s ){
+   channel::output.clear();
+   auto t0 = std::chrono::steady_clock::now();
+   for( int i = 0; i < 300000; i++ ){
+      s << "value " << i << " = "
+         << io::hex << (long long) i * 77 << io::dec << "\n";
+   }
+   double d = std::chrono::duration< double >(
+      std::chrono::steady_clock::now() - t0 ).count();
+   return channel::output.size() / d;
+}
+
+// the exit status of f() run in a child process
+template< class function >
+int status_of( function f ){
+   pid_t pid = fork();
+   if( pid == 0 ){
+      f();
+      _exit( 0 );
+   }
+   int status;
+   waitpid( pid, & status, 0 );
+   return WIFEXITED( status ) ? WEXITSTATUS( status ) : -1;
+}
+
+int main(){
+   test all( "channel blocks" );
+
+   {
+      test t( "put_n and get_n" );
+      channel_put_n< channel >::put_n( "abc", 3 );
+      channel_put_n< plain >::put_n( "abc", 3 );
+      channel_put_n< channel_sink >::put_n( "abc", 3 );
+      HWCPP_ASSERT( channel::output == "abc" );
+      HWCPP_ASSERT( plain::output == "abc" );
+
+      char s[ 6 ] = {};
+      channel::input = "hello world";
+      channel_get_n< channel >::get_n( s, 5 );
+      HWCPP_ASSERT( std::string( s ) == "hello" );
+      HWCPP_ASSERT( channel::input == " world" );
+      plain::input = "hello world";
+      channel_get_n< plain >::get_n( s, 5 );
+      HWCPP_ASSERT( std::string( s ) == "hello" );
+      HWCPP_ASSERT( plain::input == " world" );
+   }
+
+   {
+      test t( "ostream" );
+      plain::output.clear();
+      io::ostream s;
+      s.connect< plain >();
+      s << "xyz" << 42;
+      HWCPP_ASSERT( plain::output == "xyz42" );
+
+      io::ostream a;
+      a.use( channel::put );
+      double per_char = format( a );
+      std::string reference = channel::output;
+      io::ostream b;
+      b.connect< channel >();
+      double blocks = format( b );
+      HWCPP_ASSERT( channel::output == reference );
+      std::cout
+         << "      char by char " << per_char / 1e6
+         << " MB/s, put_n " << blocks / 1e6 << " MB/s\n";
+   }
+
+   {
+      test t( "get from empty input" );
+      channel::input = "ab";
+      HWCPP_ASSERT( ! channel::get_will_block() );
+      HWCPP_ASSERT( channel::get() == 'a' );
+      HWCPP_ASSERT( channel::get() == 'b' );
+      HWCPP_ASSERT( channel::get_will_block() );
+      std::cout << std::flush;
+      HWCPP_ASSERT( status_of( []{ channel::get(); } ) != 0 );
+      channel::input = "abc";
+      HWCPP_ASSERT( status_of( []{
+         char s[ 4 ];
+         channel::get_n( s, 4 );
+      } ) != 0 );
+      HWCPP_ASSERT( status_of( []{
+         char s[ 3 ];
+         channel::get_n( s, 3 );
+      } ) == 0 );
+   }
+}
@@ -0,0 +1,150 @@
+// ==========================================================================
+//
+// File      : test_clock_policy.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// a callback that stalls the virtual time by 1 ms makes three 100 us
+// clocks miss epochs: catch_up calls for each one, skip and coalesce
+// call once (late) and count the missed ones, and then continue on
+// their original epochs; a stall of a day is skipped without a loop
+// per missed epoch
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+
+using namespace hwcpp;
+
+typedef host_sim<>::clock clk;
+
+template< template< typename > class administration >
+void check( const char * name ){
+   test t( name );
+   typedef callback_implementation< clk, administration > timing;
+   typedef typename timing::template us< 100 > interval;
+   static long long t0;
+   t0 = clk::now();
+
+   // count the calls that are not on an epoch (give or take the few
+   // ns that each now() call adds to the virtual time)
+   struct aligned {
+      int off = 0;
+      void check(){
+         off += ((( clk::virtual_now - t0 ) % 100000 ) > 10 );
+      }
+   };
+
+   struct catch_up :
+      timing::template clock< interval, clock_policy::catch_up >
+   {
+      int n = 0;
+      void function() override { n++; }
+   };
+   struct skip :
+      timing::template clock< interval, clock_policy::skip >,
+      aligned
+   {
+      int n = 0;
+      void function() override { n++; aligned::check(); }
+   };
+   struct coalesce :
+      timing::template clock< interval, clock_policy::coalesce >,
+      aligned
+   {
+      int n = 0;
+      unsigned int missed = 0;
+      void function( unsigned int m ) override {
+         n++;
+         missed += m;
+         aligned::check();
+      }
+   };
+   struct stall : timing::template timer<> {
+      void function() override { clk::virtual_now += 1000000; }
+   };
+
+   catch_up a;
+   skip b;
+   coalesce c;
+   stall s;
+   s.start( timing::duration::us( 250 ));
+   timing::wait( timing::duration::us( 2000 ));
+
+   HWCPP_ASSERT( a.n == 20 );
+   HWCPP_ASSERT( b.n == 11 );
+   HWCPP_ASSERT( b.missed_total() == 9 );
+   HWCPP_ASSERT( b.off == 1 );
+   HWCPP_ASSERT( c.n == 11 );
+   HWCPP_ASSERT( c.missed == 9 );
+   HWCPP_ASSERT( c.missed_total() == 9 );
+   HWCPP_ASSERT( c.off == 1 );
+}
+
+// a stall of a day makes a 100 us clock miss 864 million epochs,
+// which must not take a loop iteration each (not for the timing 
+// wheel, which services each tick that passed)
+template< template< typename > class administration >
+void check_long_stall( const char * name ){
+   test t( name );
+   typedef callback_implementation< clk, administration > timing;
+   typedef typename timing::template us< 100 > interval;
+   const long long day = 24LL * 3600 * 1000000000;
+
+   struct skip :
+      timing::template clock< interval, clock_policy::skip >
+   {
+      int n = 0;
+      void function() override { n++; }
+   };
+   struct coalesce :
+      timing::template clock< interval, clock_policy::coalesce >
+   {
+      int n = 0;
+      unsigned int missed = 0;
+      void function( unsigned int m ) override {
+         n++;
+         missed += m;
+      }
+   };
+   struct stall : timing::template timer<> {
+      void function() override { clk::virtual_now += day; }
+   };
+
+   skip b;
+   coalesce c;
+   stall s;
+   s.start( timing::duration::us( 250 ));
+   auto t0 = std::chrono::steady_clock::now();
+   timing::wait( timing::duration::us( 1000 ));
+
+   // the stall ended that wait, the clocks are serviced by the next one
+   timing::wait( timing::duration::us( 1 ));
+   auto t1 = std::chrono::steady_clock::now();
+
+   // called at 100 and 200 us, and late for the 300 us epoch; the 
+   // epochs from 400 us to the day + 200 us before now are missed
+   HWCPP_ASSERT( b.n == 3 );
+   HWCPP_ASSERT( b.missed_total() == day / 100000 - 1 );
+   HWCPP_ASSERT( c.n == 3 );
+   HWCPP_ASSERT( c.missed == day / 100000 - 1 );
+   HWCPP_ASSERT( std::chrono::duration_cast< std::chrono::milliseconds >( 
+      t1 - t0 ).count() < 100 );
+}
+
+int main(){
+   test all( "clock policy" );
+   check< callback_administration_double_linked >( "double linked" );
+   check< callback_administration_pairing_heap >( "pairing heap" );
+   check< callback_administration_timing_wheel >( "timing wheel" );
+   check_long_stall< callback_administration_double_linked >( 
+      "a day, double linked" );
+   check_long_stall< callback_administration_pairing_heap >( 
+      "a day, pairing heap" );
+}
@@ -0,0 +1,143 @@
+// ==========================================================================
+//
+// File      : test_constant_divider.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// constant_divider<> gives the same result as / for edge cases and
+// random values, at compile time and at run time, and its speed on
+// the host compared to /
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+#include <cstdlib>
+
+using namespace hwcpp;
+
+typedef unsigned long long ull;
+
+ull random64( int i ){
+   ull x = (( ull ) rand() << 40 ) ^ (( ull ) rand() << 20 ) ^ rand();
+   return ( i & 1 ) ? ( x >> ( i % 60 )) : x;
+}
+
+template< ull d >
+void check(){
+   typedef constant_divider< d > divider;
+   static_assert( divider::divide( 1000000007ULL ) == 1000000007ULL / d,
+      "compile time" );
+   static_assert( divider::divide( ~ 0ULL ) == ~ 0ULL / d, "compile time" );
+
+   ull edges[] = {
+      0, 1, d - 1, d, d + 1, 2 * d - 1, 0xFFFFFFFFULL, 0x100000000ULL,
+      ~ 0ULL, ~ 0ULL - d, 1ULL << 63, ( 1ULL << 63 ) - 1,
+      123456789012345ULL
+   };
+   for( ull x : edges ){
+      HWCPP_ASSERT( divider::divide( x ) == x / d );
+   }
+
+   // the signed extremes, - LLONG_MIN does not fit
+   static_assert( divider::divide( LLONG_MIN ) == LLONG_MIN / (long long) d,
+      "compile time" );
+   long long signed_edges[] = { LLONG_MIN, LLONG_MIN + 1, LLONG_MAX, -1 };
+   for( long long x : signed_edges ){
+      HWCPP_ASSERT( divider::divide( x ) == x / (long long) d );
+   }
+
+   srand( d );
+   for( int i = 0; i < 100000; i++ ){
+      ull x = random64( i );
+      HWCPP_ASSERT( divider::divide( x ) == x / d );
+      long long y = ( i & 2 ) ? - (long long)( x >> 1 ) : (long long)( x >> 1 );
+      HWCPP_ASSERT( divider::divide( y ) == y / (long long) d );
+      unsigned int u = (unsigned int) x;
+      HWCPP_ASSERT( divider::divide( u ) == u / (unsigned int) d );
+   }
+}
+
+template< ull d >
+void benchmark(){
+   static ull xs[ 1024 ];
+   srand( 1 );
+   for( ull & x : xs ){
+      x = random64( 0 );
+   }
+   volatile ull sink = 0;
+   auto t0 = std::chrono::steady_clock::now();
+   for( int n = 0; n < 1000; n++ ){
+      for( ull x : xs ){
+         sink = sink + constant_divider< d >::divide( x );
+      }
+   }
+   auto t1 = std::chrono::steady_clock::now();
+   for( int n = 0; n < 1000; n++ ){
+      for( ull x : xs ){
+         sink = sink + x / d;
+      }
+   }
+   auto t2 = std::chrono::steady_clock::now();
+   std::cout
+      << "      / " << d << ": constant_divider "
+      << std::chrono::duration< double, std::nano >( t1 - t0 ).count()
+         / ( 1000 * 1024 )
+      << " ns, / "
+      << std::chrono::duration< double, std::nano >( t2 - t1 ).count()
+         / ( 1000 * 1024 )
+      << " ns\n";
+}
+
+int main(){
+   test all( "constant_divider" );
+
+   {
+      test t( "same as /" );
+      check< 1 >();
+      check< 2 >();
+      check< 3 >();
+      check< 6 >();
+      check< 24 >();
+      check< 999 >();
+      check< 1000 >();
+      check< 1000000 >();
+      check< ( 1ULL << 30 ) - 1 >();
+   }
+
+   {
+      test t( "durations" );
+      typedef host_sim<>::timing timing;
+      HWCPP_ASSERT( timing::duration::ns( 1500 ).raw() == 1500 );
+      HWCPP_ASSERT( timing::duration::us( 7 ).to_us() == 7 );
+      typedef moment_duration< unsigned int, 3 > md;
+      HWCPP_ASSERT( md::duration::ns( 1000 ).raw() == 3 );
+      HWCPP_ASSERT( md::duration( 100 ).to_ns() == 33333 );
+
+      // large tick counts, where ticks * 1000 would overflow
+      HWCPP_ASSERT( timing::duration( LLONG_MAX ).to_ns() == LLONG_MAX );
+      HWCPP_ASSERT( timing::duration( - LLONG_MAX ).to_ns() == - LLONG_MAX );
+      typedef moment_duration< long long, 3 > md3;
+      for( long long x : { LLONG_MAX / 400, - ( LLONG_MAX / 400 ) - 2, 
+            LLONG_MAX / 1000 * 3 + 2 } ){
+         HWCPP_ASSERT( md3::duration( x ).to_ns() 
+            == (long long)(( __int128 ) x * 1000 / 3 ));
+      }
+      typedef moment_duration< unsigned int, 7 > mdu;
+      HWCPP_ASSERT( mdu::duration( 4000000000U ).to_ns() 
+         == (unsigned int)( 4000000000ULL * 1000 / 7 ));
+   }
+
+   {
+      // on the host / is a single instruction, on a Cortex-M0
+      // it is a library call
+      test t( "benchmark" );
+      benchmark< 3 >();
+      benchmark< 1000 >();
+   }
+}
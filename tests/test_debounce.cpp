@@ -0,0 +1,130 @@
+// ==========================================================================
+//
+// File      : test_debounce.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// debounce<> fed with scripted bounce waveforms, and with a bouncing
+// switch in virtual time
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <cstdlib>
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef target::simulation timing;
+typedef host_sim_register< 0 > r0;
+
+typedef port_in_from_pins<
+   target::pin_in_out< 0, 0 >, target::pin_in_out< 0, 1 >,
+   target::pin_in_out< 0, 2 >, target::pin_in_out< 0, 3 >
+> keys;
+typedef debounce< keys, timing, timing::ms< 1 >, 3 > filter;
+
+typedef debounce< target::pin_in_out< 1, 0 >, timing > key;
+
+// a switch on r1 pin 0 that is closed (high) from 10 ms to 40 ms,
+// and bounces for 2 ms after each change
+struct bouncing_switch : host_sim_peripheral {
+   void update() override {
+      // the time in 0.1 ms
+      long long t = timing::now().raw() / 100000;
+      bool level;
+      if( t < 100 ){
+         level = false;
+      } else if( t < 120 ){
+         level = ( t % 3 ) != 0;
+      } else if( t < 400 ){
+         level = true;
+      } else if( t < 420 ){
+         level = ( t % 3 ) == 0;
+      } else {
+         level = false;
+      }
+      host_sim_register< 1 >::drive( 0, level );
+   }
+};
+
+int main(){
+   test all( "debounce" );
+   r0::input = 0;
+   filter::init();
+
+   {
+      test t( "scripted waveform" );
+      const char * in     = "0000101011111111110101000000";
+      const char * out    = "0000000000111111111111110000";
+      const char * press  = "0000000000100000000000000000";
+      const char * relse  = "0000000000000000000000001000";
+      for( int i = 0; in[ i ] != '\0'; i++ ){
+         filter::filter( in[ i ] == '1' ? 0x0F : 0x00 );
+         HWCPP_ASSERT( filter::get() == ( out[ i ] == '1' ? 0x0F : 0x00 ));
+         HWCPP_ASSERT( filter::pressed() == ( press[ i ] == '1' ? 0x0F : 0x00 ));
+         HWCPP_ASSERT( filter::released() == ( relse[ i ] == '1' ? 0x0F : 0x00 ));
+      }
+   }
+
+   {
+      // each bit bounces independently, compared to a counter per bit
+      test t( "random waveforms, bits independent" );
+      unsigned int state = filter::get(), count[ 4 ] = { 0, 0, 0, 0 };
+      srand( 4 );
+      for( int i = 0; i < 10000; i++ ){
+         unsigned int x = rand() & 0x0F;
+         unsigned int expect_rising = 0, expect_falling = 0;
+         for( int b = 0; b < 4; b++ ){
+            if((( x ^ state ) >> b ) & 1 ){
+               if( ++count[ b ] == 3 ){
+                  count[ b ] = 0;
+                  state ^= 1 << b;
+                  if(( state >> b ) & 1 ){
+                     expect_rising |= 1 << b;
+                  } else {
+                     expect_falling |= 1 << b;
+                  }
+               }
+            } else {
+               count[ b ] = 0;
+            }
+         }
+         filter::filter( x );
+         HWCPP_ASSERT( filter::get() == state );
+         HWCPP_ASSERT( filter::pressed() == expect_rising );
+         HWCPP_ASSERT( filter::released() == expect_falling );
+      }
+   }
+
+   {
+      test t( "bouncing switch sampled by the clock" );
+      bouncing_switch sw;
+      key::init();
+      unsigned int presses = 0, releases = 0;
+      long long pressed_at = 0, released_at = 0;
+      for( int i = 0; i < 600; i++ ){
+         timing::wait( timing::duration::us( 100 ));
+         if( key::pressed() ){
+            presses++;
+            pressed_at = timing::now().raw();
+         }
+         if( key::released() ){
+            releases++;
+            released_at = timing::now().raw();
+         }
+      }
+      HWCPP_ASSERT( presses == 1 );
+      HWCPP_ASSERT( releases == 1 );
+
+      // stable for 4 samples of 5 ms after the bouncing stopped
+      HWCPP_ASSERT( pressed_at > 12000000 && pressed_at <= 37000000 );
+      HWCPP_ASSERT( released_at > 42000000 );
+      HWCPP_ASSERT( key::get() == 0 );
+   }
+}
@@ -0,0 +1,99 @@
+// ==========================================================================
+//
+// File      : test_edge_capture.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// edge_capture<> records the selected edges of a pin or a port with
+// their time, value and edge mask, and counts the events that find
+// its buffer full
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+typedef host_sim<>::simulation timing;
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+
+typedef host_sim_pin_in_out< 0, 0 > pin;
+typedef port_in_from_pins<
+   host_sim_pin_in_out< 1, 0 >,
+   host_sim_pin_in_out< 1, 1 >
+> port;
+
+typedef edge_capture< pin, timing, 4, edge_mode::rising > rising;
+typedef edge_capture< pin, timing, 8, edge_mode::falling > falling;
+typedef edge_capture< port, timing > both;
+
+// drive pin 0 of register 0 with the waveform, 1 us per sample
+template< class capture >
+void play( const char * waveform ){
+   for( const char * p = waveform; *p; p++ ){
+      r0::drive( 0, *p == '1' );
+      capture::sample();
+      timing::wait( timing::duration::us( 1 ));
+   }
+}
+
+int main(){
+   test all( "edge_capture" );
+
+   {
+      test t( "rising edges, with overflow" );
+      r0::drive( 0, 0 );
+      rising::init();
+      long long t0 = timing::now().raw();
+      play< rising >( "010110101101" );
+      HWCPP_ASSERT( rising::available() == 4 );
+      HWCPP_ASSERT( rising::overflows == 1 );
+      rising::event e;
+      long long at[] = { 1, 3, 6, 8 };
+      for( long long i : at ){
+         HWCPP_ASSERT( rising::get( e ));
+         HWCPP_ASSERT(( e.value == 1 ) && ( e.edges == 1 ));
+
+         // each wait advances the virtual time by 1 us and a tick
+         long long us = ( e.time.raw() - t0 ) / 1000;
+         HWCPP_ASSERT( us == i );
+      }
+      HWCPP_ASSERT( ! rising::get( e ));
+   }
+
+   {
+      test t( "falling edges" );
+      r0::drive( 0, 1 );
+      falling::init();
+      play< falling >( "1100101" );
+      HWCPP_ASSERT( falling::available() == 2 );
+      HWCPP_ASSERT( falling::overflows == 0 );
+   }
+
+   {
+      test t( "both edges of a port" );
+      r1::drive( 0, 0 );
+      r1::drive( 1, 0 );
+      both::init();
+      both::event e;
+      both::sample();
+      HWCPP_ASSERT( ! both::get( e ));
+
+      r1::drive( 0, 1 );
+      r1::drive( 1, 1 );
+      both::sample();
+      r1::drive( 1, 0 );
+      both::sample();
+      HWCPP_ASSERT( both::get( e ));
+      HWCPP_ASSERT(( e.value == 3 ) && ( e.edges == 3 ));
+      HWCPP_ASSERT( both::get( e ));
+      HWCPP_ASSERT(( e.value == 1 ) && ( e.edges == 2 ));
+      HWCPP_ASSERT( ! both::get( e ));
+   }
+}
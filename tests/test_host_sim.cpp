@@ -0,0 +1,98 @@
+// ==========================================================================
+//
+// File      : test_host_sim.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// the host_sim target: pins, open-collector pins, simulated
+// peripherals and the virtual clock
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef target::timing timing;
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+
+typedef target::pin_in_out< 0, 0 > clk;
+typedef target::pin_in_out< 0, 1 > dat;
+typedef target::pin_oc< 1, 0 > sda;
+
+// a shift register on clk and dat
+struct shift_register : host_sim_peripheral {
+   bool last = false;
+   unsigned int value = 0;
+   void update() override {
+      bool c = r0::level( 0 );
+      if( c && ! last ){
+         value = ( value << 1 ) | r0::level( 1 );
+      }
+      last = c;
+   }
+};
+
+// a device that pulls sda low for 5 us
+struct puller : host_sim_peripheral {
+   long long until = target::clock::virtual_now + 5000;
+   void update() override {
+      r1::drive( 0, target::clock::virtual_now >= until );
+   }
+};
+
+int main(){
+   test all( "host_sim" );
+
+   {
+      test t( "a peripheral sees the pins" );
+      shift_register sr;
+      clk::init();
+      dat::init();
+      clk::direction_set_output();
+      dat::direction_set_output();
+      long long t0 = timing::now().raw();
+      for( int i = 7; i >= 0; i-- ){
+         dat::set(( 0xA5 >> i ) & 1 );
+         clk::set( 1 );
+         timing::wait( timing::duration::us( 1 ));
+         clk::set( 0 );
+      }
+      HWCPP_ASSERT( sr.value == 0xA5 );
+
+      // the virtual time advances by the waits only
+      HWCPP_ASSERT( timing::now().raw() - t0 == 8000 + 1 );
+   }
+
+   {
+      test t( "open-collector pin" );
+      sda::init();
+      puller p;
+      sda::set( 1 );
+      p.update();
+      HWCPP_ASSERT( sda::get() == 0 );
+      timing::us< 10 >::wait();
+      HWCPP_ASSERT( sda::get() == 1 );
+      sda::set( 0 );
+      HWCPP_ASSERT( sda::get() == 0 );
+      sda::set( 1 );
+      HWCPP_ASSERT( sda::get() == 1 );
+   }
+
+   {
+      test t( "real time" );
+      typedef host_sim< 100 * MHz, true >::timing real;
+      long long t0 = real::now().raw();
+      real::wait( real::duration::us( 2000 ));
+      long long d = real::now().raw() - t0;
+      HWCPP_ASSERT( d >= 2000000 );
+      std::cout << "      a 2000 us wait took " << d / 1000 << " us\n";
+   }
+}
@@ -0,0 +1,104 @@
+// ==========================================================================
+//
+// File      : test_idle.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// a wait sleeps until (shortly before) the next deadline instead of
+// spinning, and spins for the rest, so it still ends on time
+
+#define HWCPP_IDLE_STATISTICS 1
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace hwcpp;
+
+long long median( std::vector< long long > v ){
+   std::sort( v.begin(), v.end() );
+   return v[ v.size() / 2 ];
+}
+
+template< template< typename > class administration, bool real_time >
+void check( const char * name, long long max_median ){
+   test t( name );
+   typedef host_sim_clock< real_time > clock;
+   typedef callback_implementation< clock, administration > timing;
+   typedef idle< clock > statistics;
+
+   // a 1 ms clock that records how late it fires
+   struct ticker : timing::template clock<> {
+      int n = 0;
+      std::vector< long long > late;
+      long long next;
+      ticker(): timing::template clock<>( timing::duration::us( 1000 )){
+         next = clock::now() + 1000000;
+      }
+      void function() override {
+         n++;
+         late.push_back( clock::now() - next );
+         next += 1000000;
+      }
+   };
+
+   unsigned int sleeps = statistics::n_sleeps;
+   long long asleep = statistics::asleep;
+   ticker c;
+   long long t0 = clock::now();
+   timing::wait( timing::duration::ms( 50 ));
+   long long elapsed = clock::now() - t0;
+
+   HWCPP_ASSERT( c.n == 50 );
+   HWCPP_ASSERT( median( c.late ) <= max_median );
+   HWCPP_ASSERT( elapsed >= 50000000 );
+   HWCPP_ASSERT( statistics::n_sleeps - sleeps >= ( real_time ? 1 : 50 ));
+
+   // most of the wait is spent asleep
+   HWCPP_ASSERT( statistics::asleep - asleep > 40000000 );
+   std::cout
+      << "      " << statistics::n_sleeps - sleeps << " sleeps, "
+      << ( statistics::asleep - asleep ) / 1000 << " us asleep of "
+      << elapsed / 1000 << " us, late median " << median( c.late )
+         << " ns, max " << *std::max_element( c.late.begin(), c.late.end() )
+         << " ns\n";
+}
+
+// the plain (not callback) real-time wait
+void check_wait( long long max_median ){
+   test t( "plain wait, real time" );
+   typedef host_sim< 100 * MHz, true >::timing timing;
+   std::vector< long long > late;
+   for( int i = 0; i < 100; i++ ){
+      timing::moment m = timing::now() + timing::duration::us( 1000 );
+      timing::wait( m );
+      late.push_back(( timing::now() - m ).raw() );
+   }
+   HWCPP_ASSERT( *std::min_element( late.begin(), late.end() ) >= 0 );
+   HWCPP_ASSERT( median( late ) <= max_median );
+   std::cout
+      << "      late median " << median( late ) << " ns, max " 
+      << *std::max_element( late.begin(), late.end() ) << " ns\n";
+}
+
+int main(){
+   test all( "idle" );
+   check< callback_administration_double_linked, false >(
+      "double linked, virtual time", 2 );
+   check< callback_administration_pairing_heap, false >(
+      "pairing heap, virtual time", 2 );
+   check< callback_administration_timing_wheel, false >(
+      "timing wheel, virtual time", 2 );
+
+   // a host sleep wakes up tens of us late, the spin after it must
+   // absorb that (the worst case depends on the host scheduler)
+   check< callback_administration_timing_wheel, true >(
+      "timing wheel, real time", 20000 );
+   check_wait( 20000 );
+}
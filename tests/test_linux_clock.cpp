@@ -0,0 +1,52 @@
+// ==========================================================================
+//
+// File      : test_linux_clock.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// a linux_clock wait sleeps, then spins, and never returns early;
+// the lateness depends on the host, so it is only printed
+
+#define HWCPP_IDLE_STATISTICS 1
+#include "hwcpp/targets/linux.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+typedef linux_clock< 500, CLOCK_MONOTONIC > clk;
+typedef timing_implementation< clk > timing;
+
+int main(){
+   test all( "linux clock" );
+
+   long long worst = 0, total = 0;
+   bool early = false;
+   unsigned int sleeps = idle< clk >::n_sleeps;
+   for( int i = 0; i < 300; i++ ){
+      timing::moment t = timing::now() + timing::duration::us( 1000 + i );
+      timing::wait( t );
+      long long late = ( timing::now() - t ).raw();
+      early |= ( late < 0 );
+      total += late;
+      if( late > worst ){
+         worst = late;
+      }
+   }
+
+   HWCPP_ASSERT( ! early );
+   HWCPP_ASSERT( idle< clk >::n_sleeps - sleeps > 0 );
+   HWCPP_ASSERT(
+      clk::wakeup_late_percentile( 50 )
+         <= clk::wakeup_late_percentile( 99 ));
+   std::cout
+      << "      returned late: mean " << total / 300
+         << " ns, worst " << worst << " ns\n"
+      << "      woke up late: 50% " << clk::wakeup_late_percentile( 50 )
+         << " ns, 99% " << clk::wakeup_late_percentile( 99 ) << " ns\n";
+}
@@ -0,0 +1,267 @@
+// ==========================================================================
+//
+// File      : test_lpc1114_uart.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// the buffered LPC1114 UART against a mock register block that
+// emulates the 16 character FIFOs, the IIR priorities and the THRE
+// event, and calls the interrupt handler when an enabled interrupt
+// is pending
+
+#include "hwcpp/targets/lpc1114_uart.hpp"
+#include "hwcpp/core/test.hpp"
+#include <deque>
+#include <string>
+
+using namespace hwcpp;
+
+void irq();
+
+struct mock_uart {
+   std::deque< char > tx_fifo, rx_fifo;
+   std::string wire;
+   unsigned int ier = 0;
+   bool overrun = false;
+   bool thre_pending = false;
+   bool tx_fifo_overflow = false;
+   bool irq_enabled = true;
+   unsigned int in_isr = 0;
+
+   struct thr_t {
+      mock_uart * u;
+      void operator=( char c ){
+         u->tx_fifo_overflow |= ( u->tx_fifo.size() >= 16 );
+         u->tx_fifo.push_back( c );
+         u->thre_pending = false;
+      }
+   } THR{ this };
+
+   struct rbr_t {
+      mock_uart * u;
+      operator char(){
+         char c = u->rx_fifo.front();
+         u->rx_fifo.pop_front();
+         return c;
+      }
+   } RBR{ this };
+
+   // enabling THRE with an empty FIFO raises it
+   struct ier_t {
+      mock_uart * u;
+      void operator=( unsigned int x ){
+         bool thre = ( x & 2 ) && ! ( u->ier & 2 );
+         u->ier = x;
+         if( thre && u->tx_fifo.empty() ){
+            u->thre_pending = true;
+         }
+         u->interrupt();
+      }
+      operator unsigned int(){ return u->ier; }
+   } IER{ this };
+
+   struct fcr_t {
+      mock_uart * u;
+      void operator=( unsigned int ){
+         u->tx_fifo.clear();
+         u->rx_fifo.clear();
+      }
+   } FCR{ this };
+
+   // reading LSR clears the overrun flag
+   struct lsr_t {
+      mock_uart * u;
+      operator unsigned int(){
+         unsigned int r =
+            ( u->rx_fifo.empty() ? 0 : 0x01 )
+            | ( u->overrun ? 0x02 : 0 )
+            | ( u->tx_fifo.empty() ? 0x20 : 0 );
+         u->overrun = false;
+         return r;
+      }
+   } LSR{ this };
+
+   // receive data before THRE, reading a THRE identification clears it
+   struct iir_t {
+      mock_uart * u;
+      operator unsigned int(){
+         if(( u->ier & 1 ) && ! u->rx_fifo.empty() ){
+            return 0x04;
+         }
+         if(( u->ier & 2 ) && u->thre_pending ){
+            u->thre_pending = false;
+            return 0x02;
+         }
+         return 0x01;
+      }
+   } IIR{ this };
+
+   // the level fields are 4 bits wide, a full FIFO reads 0xF
+   struct fifolvl_t {
+      mock_uart * u;
+      static unsigned int field( unsigned int n ){
+         return ( n > 0x0F ) ? 0x0F : n;
+      }
+      operator unsigned int(){
+         return ( field( u->tx_fifo.size()) << 8 ) 
+            | field( u->rx_fifo.size());
+      }
+   } FIFOLVL{ this };
+
+   void interrupt(){
+      if( ! irq_enabled || in_isr ){
+         return;
+      }
+      if((( ier & 1 ) && ! rx_fifo.empty() ) || (( ier & 2 ) && thre_pending )){
+         in_isr++;
+         irq();
+         in_isr--;
+      }
+   }
+
+   // one character time passes
+   void tick(){
+      if( ! tx_fifo.empty() ){
+         wire += tx_fifo.front();
+         tx_fifo.pop_front();
+         if( tx_fifo.empty() ){
+            thre_pending = true;
+         }
+      }
+      interrupt();
+   }
+
+   void ticks( int n ){
+      for( int i = 0; i < n; i++ ){
+         tick();
+      }
+   }
+
+   void receive( char c ){
+      if( rx_fifo.size() >= 16 ){
+         overrun = true;
+      } else {
+         rx_fifo.push_back( c );
+      }
+      interrupt();
+   }
+} mock;
+
+struct registers {
+   static mock_uart * uart(){ return & mock; }
+};
+
+typedef lpc1114_uart_buffered< registers, 64, 32 > uart;
+
+void irq(){ uart::isr(); }
+
+int main(){
+   test all( "lpc1114 buffered uart" );
+   uart::init();
+
+   {
+      test t( "transmit faster than the wire" );
+      std::string s;
+      for( int i = 0; i < 1000; i++ ){
+         s += char( 'a' + i % 26 );
+      }
+      for( unsigned int i = 0; i < s.size(); i++ ){
+         while( uart::put_will_block() ){
+            mock.tick();
+         }
+         uart::put( s[ i ] );
+         if( i % 3 == 2 ){
+            mock.tick();
+         }
+      }
+      mock.ticks( 200 );
+      HWCPP_ASSERT( mock.wire == s );
+      HWCPP_ASSERT( ! mock.tx_fifo_overflow );
+   }
+
+   {
+      test t( "receive" );
+      std::string s, got;
+      for( int i = 0; i < 100; i++ ){
+         s += char( 'A' + i % 26 );
+         mock.receive( s.back() );
+         if( i % 2 ){
+            while( ! uart::get_will_block() ){
+               got += uart::get();
+            }
+         }
+      }
+      while( ! uart::get_will_block() ){
+         got += uart::get();
+      }
+      HWCPP_ASSERT( got == s );
+      HWCPP_ASSERT( uart::rx_overruns == 0 );
+      HWCPP_ASSERT( uart::hw_overruns == 0 );
+   }
+
+   {
+      // 50 unread characters into a 32 character buffer
+      test t( "receive overrun" );
+      for( int i = 0; i < 50; i++ ){
+         mock.receive( 'x' );
+      }
+      HWCPP_ASSERT( uart::rx_overruns == 18 );
+      int n = 0;
+      while( ! uart::get_will_block() ){
+         uart::get();
+         n++;
+      }
+      HWCPP_ASSERT( n == 32 );
+   }
+
+   {
+      test t( "transmit with interrupts disabled" );
+      mock.irq_enabled = false;
+      mock.wire.clear();
+      for( int i = 0; i < 200; i++ ){
+         uart::put( 'z' );
+         mock.tick();
+      }
+      for( int i = 0; i < 100; i++ ){
+         mock.tick();
+         uart::put_will_block();
+      }
+      mock.irq_enabled = true;
+      mock.ticks( 100 );
+      HWCPP_ASSERT( mock.wire == std::string( 200, 'z' ));
+      HWCPP_ASSERT( ! mock.tx_fifo_overflow );
+   }
+
+   {
+      test t( "blocks" );
+      mock.wire.clear();
+      std::string s( 500, 0 );
+      for( int i = 0; i < 500; i++ ){
+         s[ i ] = char( i );
+      }
+      for( unsigned int done = 0; done < s.size(); ){
+         unsigned int n = ( s.size() - done < 37 ) ? s.size() - done : 37;
+         uart::put_n( s.data() + done, n );
+         done += n;
+         mock.ticks( 40 );
+      }
+      mock.ticks( 100 );
+      HWCPP_ASSERT( mock.wire == s );
+      HWCPP_ASSERT( ! mock.tx_fifo_overflow );
+
+      for( int i = 0; i < 20; i++ ){
+         mock.receive( char( 100 + i ));
+      }
+      char r[ 20 ];
+      uart::get_n( r, 20 );
+      for( int i = 0; i < 20; i++ ){
+         HWCPP_ASSERT( r[ i ] == char( 100 + i ));
+      }
+   }
+}
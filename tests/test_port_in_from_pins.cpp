@@ -0,0 +1,95 @@
+// ==========================================================================
+//
+// File      : test_port_in_from_pins.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// port_in_from_pins reads each port register once per get(),
+// and pins without a register one by one
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+
+// a pin that has no port register
+struct other : pin_in_out_archetype {
+   static unsigned int value, n_reads;
+   static void init(){}
+   static void direction_set_input(){}
+   static void direction_set_output(){}
+   static void set( bool x ){ value = x; }
+   static bool get(){ n_reads++; return value; }
+};
+unsigned int other::value, other::n_reads;
+
+#define PINS \
+   target::pin_in_out< 0, 3 >, target::pin_in_out< 0, 4 >, \
+   target::pin_in_out< 1, 0 >, other, \
+   target::pin_in_out< 0, 7 >, target::pin_in_out< 1, 1 >, \
+   target::pin_in_out< 0, 5 >, target::pin_in_out< 0, 6 >
+
+typedef port_out_from_pins< PINS > out_bus;
+typedef port_in_from_pins< PINS > in_bus;
+typedef port_in_out_from_pins< PINS > in_out_bus;
+
+int main(){
+   test all( "port_in_from_pins" );
+   // the pins are read back as outputs
+   in_bus::init();
+   out_bus::init();
+
+   {
+      test t( "all values, one read per register" );
+      for( unsigned int x = 0; x < 256; x++ ){
+         out_bus::set( x );
+         r0::counters_clear();
+         r1::counters_clear();
+         other::n_reads = 0;
+         HWCPP_ASSERT( in_bus::get() == x );
+         HWCPP_ASSERT( r0::n_reads == 1 );
+         HWCPP_ASSERT( r1::n_reads == 1 );
+         HWCPP_ASSERT( other::n_reads == 1 );
+      }
+   }
+
+   {
+      test t( "in-out port" );
+      for( unsigned int x = 0; x < 256; x++ ){
+         in_out_bus::set( x ^ 0xFF );
+         HWCPP_ASSERT( in_out_bus::get() == ( x ^ 0xFF ));
+      }
+   }
+
+   {
+      test t( "register reads" );
+      r0::counters_clear();
+      r1::counters_clear();
+      target::pin_in_out< 0, 3 >::get();
+      target::pin_in_out< 0, 4 >::get();
+      target::pin_in_out< 1, 0 >::get();
+      target::pin_in_out< 0, 7 >::get();
+      target::pin_in_out< 1, 1 >::get();
+      target::pin_in_out< 0, 5 >::get();
+      target::pin_in_out< 0, 6 >::get();
+      unsigned int per_pin = r0::n_reads + r1::n_reads;
+      r0::counters_clear();
+      r1::counters_clear();
+      in_bus::get();
+      unsigned int per_port = r0::n_reads + r1::n_reads;
+      HWCPP_ASSERT( per_port == 2 );
+      std::cout
+         << "      register reads: " << per_pin << " pin by pin, "
+         << per_port << " for the port\n";
+   }
+}
@@ -0,0 +1,106 @@
+// ==========================================================================
+//
+// File      : test_port_out_from_pins.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// port_out_from_pins writes each port register with one set_masked(),
+// and pins without a register one by one
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+
+// a pin that has no port register
+struct other : pin_out_archetype {
+   static unsigned int value, n_writes;
+   static void init(){}
+   static void set( bool x ){ value = x; n_writes++; }
+};
+unsigned int other::value, other::n_writes;
+
+typedef port_out_from_pins<
+   target::pin_in_out< 0, 3 >, target::pin_in_out< 0, 4 >,
+   target::pin_in_out< 1, 0 >, other,
+   target::pin_in_out< 0, 7 >, target::pin_in_out< 1, 1 >,
+   target::pin_in_out< 0, 5 >, target::pin_in_out< 0, 6 >
+> bus;
+
+// the same pins, written one by one
+template< class p > void set_bit( unsigned int x, int n ){ p::set(( x >> n ) & 1 ); }
+void bus_per_pin( unsigned int x ){
+   set_bit< target::pin_in_out< 0, 3 >>( x, 0 );
+   set_bit< target::pin_in_out< 0, 4 >>( x, 1 );
+   set_bit< target::pin_in_out< 1, 0 >>( x, 2 );
+   set_bit< other >( x, 3 );
+   set_bit< target::pin_in_out< 0, 7 >>( x, 4 );
+   set_bit< target::pin_in_out< 1, 1 >>( x, 5 );
+   set_bit< target::pin_in_out< 0, 5 >>( x, 6 );
+   set_bit< target::pin_in_out< 0, 6 >>( x, 7 );
+}
+
+template< class f >
+double sets_per_us( f set ){
+   const unsigned int n = 2000000;
+   auto t0 = std::chrono::steady_clock::now();
+   for( unsigned int i = 0; i < n; i++ ){
+      set( i );
+   }
+   auto t1 = std::chrono::steady_clock::now();
+   return n / std::chrono::duration< double, std::micro >( t1 - t0 ).count();
+}
+
+int main(){
+   test all( "port_out_from_pins" );
+   bus::init();
+
+   {
+      test t( "all values, one write per register" );
+      for( unsigned int x = 0; x < 256; x++ ){
+         r0::counters_clear();
+         r1::counters_clear();
+         other::n_writes = 0;
+         bus::set( x );
+         unsigned int e0 =
+              ((( x >> 0 ) & 1 ) << 3 ) | ((( x >> 1 ) & 1 ) << 4 )
+            | ((( x >> 4 ) & 1 ) << 7 ) | ((( x >> 6 ) & 1 ) << 5 )
+            | ((( x >> 7 ) & 1 ) << 6 );
+         unsigned int e1 =
+            ((( x >> 2 ) & 1 ) << 0 ) | ((( x >> 5 ) & 1 ) << 1 );
+         HWCPP_ASSERT( r0::value == e0 );
+         HWCPP_ASSERT( r1::value == e1 );
+         HWCPP_ASSERT( other::value == (( x >> 3 ) & 1 ));
+         HWCPP_ASSERT( r0::n_writes == 1 );
+         HWCPP_ASSERT( r1::n_writes == 1 );
+         HWCPP_ASSERT( other::n_writes == 1 );
+      }
+   }
+
+   {
+      test t( "benchmark" );
+      r0::counters_clear();
+      double a = sets_per_us( bus_per_pin );
+      unsigned int writes_a = r0::n_writes;
+      r0::counters_clear();
+      double b = sets_per_us( bus::set );
+      unsigned int writes_b = r0::n_writes;
+      HWCPP_ASSERT( writes_b * 5 == writes_a );
+      std::cout
+         << "      per pin : " << a << " sets/us, "
+            << writes_a << " register 0 writes\n"
+         << "      coalesced : " << b << " sets/us, "
+            << writes_b << " register 0 writes\n";
+   }
+}
@@ -0,0 +1,104 @@
+// ==========================================================================
+//
+// File      : test_port_permutation.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// the pins of a port wired to its register in an arbitrary order are
+// written and read with lookup tables, pins wired in order with runs
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef host_sim_register< 0 > r0;
+typedef host_sim_register< 1 > r1;
+typedef host_sim_register< 2 > r2;
+
+template< int port, int pin >
+   using p = target::pin_in_out< port, pin >;
+
+// value bit i is register 0 bit perm[ i ]
+const int perm[] = { 7, 2, 5, 0, 6, 1, 4, 3 };
+typedef port_in_out_from_pins<
+   p< 0, 7 >, p< 0, 2 >, p< 0, 5 >, p< 0, 0 >,
+   p< 0, 6 >, p< 0, 1 >, p< 0, 4 >, p< 0, 3 >,
+   p< 1, 3 >, p< 1, 4 >
+> scrambled;
+
+typedef port_in_out_from_pins<
+   p< 2, 3 >, p< 2, 4 >, p< 2, 5 >, p< 2, 6 >
+> ordered;
+
+typedef _register_table< r0, scrambled::pin_list >::map map;
+
+template< class access >
+double scatters_per_us( unsigned int & sum ){
+   const unsigned int n = 20000000;
+   auto t0 = std::chrono::steady_clock::now();
+   for( unsigned int i = 0; i < n; i++ ){
+      sum += access::scatter( i + sum );
+   }
+   auto t1 = std::chrono::steady_clock::now();
+   return n / std::chrono::duration< double, std::micro >( t1 - t0 ).count();
+}
+
+int main(){
+   test all( "port permutation" );
+
+   {
+      test t( "selection" );
+      typedef _register_table< r0, scrambled::pin_list > scrambled_r0;
+      typedef _register_table< r2, ordered::pin_list > ordered_r2;
+      HWCPP_ASSERT( scrambled_r0::map::runs == 7 );
+      HWCPP_ASSERT(( same_type<
+         scrambled_r0::type, _register_access< map, true > >::value ));
+      HWCPP_ASSERT( ordered_r2::map::runs == 1 );
+      HWCPP_ASSERT(( same_type<
+         ordered_r2::type, _register_access< ordered_r2::map, false >
+      >::value ));
+   }
+
+   {
+      test t( "all values" );
+      scrambled::init();
+      scrambled::direction_set_output();
+      for( unsigned int x = 0; x < 1024; x++ ){
+         r0::counters_clear();
+         scrambled::set( x );
+         unsigned int e = 0;
+         for( int i = 0; i < 8; i++ ){
+            e |= (( x >> i ) & 1 ) << perm[ i ];
+         }
+         HWCPP_ASSERT( r0::value == e );
+         HWCPP_ASSERT( r0::n_writes == 1 );
+         HWCPP_ASSERT( r1::value == ((( x >> 8 ) & 3 ) << 3 ));
+         HWCPP_ASSERT( scrambled::get() == x );
+         HWCPP_ASSERT( r0::n_reads == 1 );
+      }
+      ordered::init();
+      ordered::direction_set_output();
+      ordered::set( 0x9 );
+      HWCPP_ASSERT( r2::value == ( 0x9 << 3 ));
+   }
+
+   {
+      test t( "tables against runs" );
+      unsigned int a = 0, b = 0;
+      double runs = scatters_per_us< _register_access< map, false >>( a );
+      double lut = scatters_per_us< _register_access< map, true >>( b );
+      HWCPP_ASSERT( a == b );
+      std::cout
+         << "      7 runs : " << runs << " scatters/us\n"
+         << "      tables : " << lut << " scatters/us\n";
+   }
+}
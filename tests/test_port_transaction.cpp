@@ -0,0 +1,134 @@
+// ==========================================================================
+//
+// File      : test_port_transaction.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// port_transaction writes the pins that share a register together,
+// and hd44780 uses it to set rs and the data nibble in one write
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <string>
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef host_sim_register< 0 > r0;
+
+// a pin and a port that have no register
+struct other : pin_out_archetype {
+   static unsigned int value, n_writes;
+   static void init(){}
+   static void set( bool x ){ value = x; n_writes++; }
+};
+unsigned int other::value, other::n_writes;
+
+struct other_port : port_out_archetype< 4 > {
+   static unsigned int value, n_writes;
+   static void init(){}
+   static void set( unsigned int x ){ value = x; n_writes++; }
+};
+unsigned int other_port::value, other_port::n_writes;
+
+typedef target::pin_in_out< 0, 8 > rs;
+typedef port_out_from_pins<
+   target::pin_in_out< 0, 0 >, target::pin_in_out< 0, 1 >,
+   target::pin_in_out< 0, 2 >, target::pin_in_out< 0, 3 >
+> data;
+typedef port_transaction< rs, data, other, other_port > transaction;
+
+// a simulated HD44780 in 4-bit mode on r1: data on bits 0..3,
+// rs on bit 4, e on bit 5, which latches a nibble when e goes low
+struct lcd_sim : host_sim_peripheral {
+   bool e = false, high = true;
+   unsigned int byte = 0;
+   std::string text;
+   unsigned int n_commands = 0;
+   void update() override {
+      unsigned int r = host_sim_register< 1 >::levels();
+      bool new_e = ( r >> 5 ) & 1;
+      if( e && ! new_e ){
+         byte = (( byte << 4 ) | ( r & 0x0F )) & 0xFF;
+         high = ! high;
+         if( high ){
+            if(( r >> 4 ) & 1 ){
+               text += (char) byte;
+            } else {
+               n_commands++;
+            }
+         }
+      }
+      e = new_e;
+   }
+};
+
+typedef hd44780<
+   port_out_from_pins<
+      target::pin_in_out< 1, 0 >, target::pin_in_out< 1, 1 >,
+      target::pin_in_out< 1, 2 >, target::pin_in_out< 1, 3 >
+   >,
+   target::pin_in_out< 1, 4 >,
+   target::pin_in_out< 1, 5 >,
+   16, 2,
+   target::timing
+> lcd;
+
+int main(){
+   test all( "port_transaction" );
+
+   {
+      test t( "written when it goes out of scope" );
+      r0::counters_clear();
+      {
+         transaction tr;
+         tr.set< rs >( 1 );
+         tr.set< data >( 0xA );
+         tr.set< other_port >( 0x5 );
+         HWCPP_ASSERT( r0::n_writes == 0 );
+         HWCPP_ASSERT( other_port::n_writes == 0 );
+      }
+      HWCPP_ASSERT( r0::value == 0x10A );
+      HWCPP_ASSERT( r0::n_writes == 1 );
+      HWCPP_ASSERT( other::n_writes == 0 );
+      HWCPP_ASSERT( other_port::value == 0x5 );
+      HWCPP_ASSERT( other_port::n_writes == 1 );
+   }
+
+   {
+      test t( "only the items that were set are written" );
+      transaction tr;
+      tr.set< other >( 1 );
+      tr.commit();
+      HWCPP_ASSERT( r0::n_writes == 1 );
+      HWCPP_ASSERT( other::value == 1 );
+      HWCPP_ASSERT( other_port::n_writes == 1 );
+      tr.set< data >( 0x1 );
+      tr.commit();
+      HWCPP_ASSERT( r0::value == 0x101 );
+      HWCPP_ASSERT( r0::n_writes == 2 );
+   }
+
+   {
+      test t( "hd44780" );
+      lcd::init();
+      lcd_sim sim;
+      host_sim_register< 1 >::counters_clear();
+      lcd::write( 'h' );
+      lcd::write( 'i' );
+
+      // per nibble: one write for rs and the data, two for e
+      HWCPP_ASSERT( host_sim_register< 1 >::n_writes == 2 * 2 * 3 );
+      HWCPP_ASSERT( sim.text == "hi" );
+      HWCPP_ASSERT( sim.n_commands == 0 );
+      lcd::goto_xy( 3, 1 );
+      HWCPP_ASSERT( sim.n_commands == 1 );
+      HWCPP_ASSERT( sim.byte == 0x80 + 0x40 + 3 );
+   }
+}
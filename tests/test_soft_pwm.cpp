@@ -0,0 +1,111 @@
+// ==========================================================================
+//
+// File      : test_soft_pwm.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// soft_pwm<> duty cycles measured in virtual time, and its cost
+// per tick on the host
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+
+using namespace hwcpp;
+
+typedef host_sim<>::simulation timing;
+
+// a port that accumulates the high time of each pin
+struct recorder : port_out_archetype< 4 > {
+   static unsigned int value, n_writes;
+   static long long last, high[ 4 ];
+   static void init(){}
+   static void set( unsigned int x ){
+      long long now = timing::now().raw();
+      for( int i = 0; i < 4; i++ ){
+         if(( value >> i ) & 1 ){
+            high[ i ] += now - last;
+         }
+      }
+      last = now;
+      value = x;
+      n_writes++;
+   }
+   static void clear(){
+      for( int i = 0; i < 4; i++ ){
+         high[ i ] = 0;
+      }
+      n_writes = 0;
+   }
+};
+unsigned int recorder::value, recorder::n_writes;
+long long recorder::last, recorder::high[ 4 ];
+
+// 4 bits: a frame is 15 ticks of 10 us, written in 4 bit planes
+typedef soft_pwm< recorder, timing, 4, timing::us< 10 >> pwm;
+
+int main(){
+   test all( "soft_pwm" );
+   pwm::init();
+
+   {
+      test t( "duty cycles" );
+      pwm::set( 0, 5 );
+      pwm::set( 1, 15 );
+      pwm::set( 2, 0 );
+      pwm::set( 3, 8 );
+      pwm::commit();
+
+      // let the change take effect at a frame boundary
+      timing::wait( timing::duration::us( 300 ));
+      recorder::clear();
+      timing::wait( timing::duration::us( 10 * 150 ));
+      HWCPP_ASSERT( recorder::n_writes == 10 * 4 );
+      HWCPP_ASSERT( recorder::high[ 0 ] == 10 * 50000 );
+      HWCPP_ASSERT( recorder::high[ 1 ] == 10 * 150000 );
+      HWCPP_ASSERT( recorder::high[ 2 ] == 0 );
+      HWCPP_ASSERT( recorder::high[ 3 ] == 10 * 80000 );
+   }
+
+   {
+      test t( "out of range arguments" );
+
+      // a pin the port does not have is ignored
+      pwm::set( 4, 15 );
+      pwm::set( 31, 15 );
+      pwm::set( 1000, 15 );
+
+      // a duty above period is clamped
+      pwm::set( 2, 1000 );
+      pwm::commit();
+      timing::wait( timing::duration::us( 300 ));
+      recorder::clear();
+      timing::wait( timing::duration::us( 10 * 150 ));
+      HWCPP_ASSERT( recorder::high[ 0 ] == 10 * 50000 );
+      HWCPP_ASSERT( recorder::high[ 2 ] == 10 * 150000 );
+      HWCPP_ASSERT(( recorder::value & ~ 0x0F ) == 0 );
+   }
+
+   {
+      test t( "benchmark" );
+      recorder::clear();
+      auto t0 = std::chrono::steady_clock::now();
+      timing::wait( timing::duration::ms( 10000 ));
+      auto t1 = std::chrono::steady_clock::now();
+      double s = std::chrono::duration< double >( t1 - t0 ).count();
+
+      // a frame of 15 ticks takes 4 callbacks
+      double ticks = recorder::n_writes * 15.0 / 4;
+      std::cout
+         << "      " << recorder::n_writes / s / 1e6
+            << " M bit planes/s, " << ticks / s / 1e6 << " M ticks/s\n"
+         << "      CPU share at 10 us per tick: "
+            << 100.0 * s / 10.0 << "%\n";
+   }
+}
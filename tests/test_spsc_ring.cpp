@@ -0,0 +1,147 @@
+// ==========================================================================
+//
+// File      : test_spsc_ring.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// spsc_ring<>: the spans at the wrap-around, a producer and a consumer
+// thread that pass 3 million sequence numbers element-wise and in
+// bulk, and the throughput of both
+
+#include "hwcpp/core/basics.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace hwcpp;
+
+const unsigned int total = 3000000;
+
+// a static ring is empty before any code runs
+static spsc_ring< unsigned int, 256 > ring;
+
+double seconds_since( std::chrono::steady_clock::time_point t0 ){
+   return std::chrono::duration< double >(
+      std::chrono::steady_clock::now() - t0 ).count();
+}
+
+int main(){
+   test all( "spsc_ring" );
+
+   {
+      test t( "one thread" );
+      spsc_ring< int, 8 > r;
+      r.clear();
+      int x;
+      HWCPP_ASSERT( r.empty() );
+      HWCPP_ASSERT( ! r.pop( x ));
+      for( int i = 0; i < 8; i++ ){
+         HWCPP_ASSERT( r.push( i ));
+      }
+      HWCPP_ASSERT( r.full() );
+      HWCPP_ASSERT( ! r.push( 8 ));
+      HWCPP_ASSERT( r.pop( x ) && ( x == 0 ));
+      HWCPP_ASSERT( r.pop( x ) && ( x == 1 ));
+
+      // the free room wraps around: two spans
+      int * p;
+      HWCPP_ASSERT( r.push_span( p ) == 2 );
+      p[ 0 ] = 8;
+      p[ 1 ] = 9;
+      r.push_commit( 2 );
+      HWCPP_ASSERT( r.count() == 8 );
+      HWCPP_ASSERT( r.pop_span( p ) == 6 );
+      HWCPP_ASSERT( p[ 0 ] == 2 );
+      r.pop_commit( 6 );
+      HWCPP_ASSERT( r.pop_span( p ) == 2 );
+      HWCPP_ASSERT(( p[ 0 ] == 8 ) && ( p[ 1 ] == 9 ));
+      r.pop_commit( 2 );
+      HWCPP_ASSERT( r.empty() );
+
+      // bulk copies stop when the ring is full or empty
+      int a[ 12 ], b[ 12 ];
+      for( int i = 0; i < 12; i++ ){
+         a[ i ] = 100 + i;
+      }
+      HWCPP_ASSERT( r.push_n( a, 12 ) == 8 );
+      HWCPP_ASSERT( r.pop_n( b, 12 ) == 8 );
+      for( int i = 0; i < 8; i++ ){
+         HWCPP_ASSERT( b[ i ] == 100 + i );
+      }
+   }
+
+   {
+      test t( "two threads, element-wise" );
+      HWCPP_ASSERT( ring.empty() );
+      auto t0 = std::chrono::steady_clock::now();
+      std::thread producer( []{
+         for( unsigned int i = 0; i < total; ){
+            if( ring.push( i )){
+               i++;
+            } else {
+               std::this_thread::yield();
+            }
+         }
+      });
+      unsigned int wrong = 0, expect = 0, x;
+      while( expect < total ){
+         if( ring.pop( x )){
+            wrong += ( x != expect );
+            expect++;
+         } else {
+            std::this_thread::yield();
+         }
+      }
+      producer.join();
+      double s = seconds_since( t0 );
+      HWCPP_ASSERT( wrong == 0 );
+      HWCPP_ASSERT( ring.empty() );
+      std::cout << "      " << total / s / 1e6 << " M elements/s\n";
+   }
+
+   {
+      test t( "two threads, push_n and pop_span" );
+      auto t0 = std::chrono::steady_clock::now();
+      std::thread producer( []{
+         unsigned int buffer[ 64 ];
+         for( unsigned int i = 0; i < total; ){
+            unsigned int n = 0;
+            for( ; ( n < 64 ) && ( i + n < total ); n++ ){
+               buffer[ n ] = i + n;
+            }
+            for( unsigned int k = 0; k < n; ){
+               unsigned int d = ring.push_n( buffer + k, n - k );
+               if( d == 0 ){
+                  std::this_thread::yield();
+               }
+               k += d;
+            }
+            i += n;
+         }
+      });
+      unsigned int wrong = 0, expect = 0;
+      while( expect < total ){
+         unsigned int * p;
+         unsigned int m = ring.pop_span( p );
+         for( unsigned int i = 0; i < m; i++ ){
+            wrong += ( p[ i ] != expect + i );
+         }
+         ring.pop_commit( m );
+         expect += m;
+         if( m == 0 ){
+            std::this_thread::yield();
+         }
+      }
+      producer.join();
+      double s = seconds_since( t0 );
+      HWCPP_ASSERT( wrong == 0 );
+      HWCPP_ASSERT( ring.empty() );
+      std::cout << "      " << total / s / 1e6 << " M elements/s\n";
+   }
+}
@@ -0,0 +1,142 @@
+// ==========================================================================
+//
+// File      : test_timer_isr.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// timers started by start_from_isr() each fire once, also when a
+// second thread (standing in for an interrupt handler) starts them
+// while the main thread services the callbacks, and a timer started
+// between the drain of the queue and the sleep fires at its due moment
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace hwcpp;
+
+typedef host_sim<>::clock clk;
+
+template< template< typename > class administration >
+void check( const char * name ){
+   test t( name );
+   typedef callback_implementation< clk, administration > timing;
+
+   struct timer : timing::template timer<> {
+      int n = 0;
+      void function() override { n++; }
+   };
+
+   {
+      // the queue holds HWCPP_CALLBACK_ISR_QUEUE starts until an update
+      std::vector< timer > timers( HWCPP_CALLBACK_ISR_QUEUE + 1 );
+      for( int i = 0; i < HWCPP_CALLBACK_ISR_QUEUE; i++ ){
+         HWCPP_ASSERT( timers[ i ].start_from_isr( timing::duration::us( 1 )));
+      }
+      HWCPP_ASSERT( ! timers.back().start_from_isr( timing::duration::us( 1 )));
+      timing::wait( timing::duration::us( 10 ));
+      for( int i = 0; i < HWCPP_CALLBACK_ISR_QUEUE; i++ ){
+         HWCPP_ASSERT( timers[ i ].n == 1 );
+      }
+      HWCPP_ASSERT( timers.back().n == 0 );
+   }
+
+   std::vector< timer > timers( 2000 );
+   std::atomic< bool > done( false );
+   unsigned int full = 0;
+   std::thread isr( [ & ]{
+      for( auto & x : timers ){
+         while( ! x.start_from_isr(
+            typename timing::moment() + typename timing::duration( 5000 )
+         )){
+            full++;
+            std::this_thread::yield();
+         }
+      }
+      done = true;
+   });
+   while( ! done ){
+      timing::wait( timing::duration::us( 1 ));
+   }
+   timing::wait( timing::duration::us( 100 ));
+   isr.join();
+
+   int wrong = 0;
+   for( auto & x : timers ){
+      wrong += ( x.n != 1 );
+   }
+   HWCPP_ASSERT( wrong == 0 );
+   std::cout << "      the queue was full " << full << " times\n";
+}
+
+// jumps to the end of a sleep like virtual_clock, but first raises
+// the interrupt: after the wait drained the queue, before the sleep
+struct racy_clock : timing_support< long long int, 1000 > {
+   static base ticks;
+   static void ( * interrupt )();
+   static void init(){}
+   static base now(){ return ticks; }
+
+   typedef void has_idle_until;
+   static constexpr base idle_margin = 0;
+   static void idle_until( base t, bool ( * pending )() = nullptr ){
+      if( interrupt != nullptr ){
+         void ( * f )() = interrupt;
+         interrupt = nullptr;
+         f();
+      }
+
+      // the check with the interrupts masked
+      if(( pending != nullptr ) && pending() ){
+         return;
+      }
+      if( t > ticks ){
+         ticks = t;
+      }
+   }
+};
+
+racy_clock::base racy_clock::ticks = 0;
+void ( * racy_clock::interrupt )() = nullptr;
+
+template< template< typename > class administration >
+void check_race( const char * name ){
+   test t( name );
+   typedef callback_implementation< racy_clock, administration > timing;
+
+   static struct timer : timing::template timer<> {
+      long long at = -1;
+      void function() override { at = racy_clock::ticks; }
+   } x;
+   x.at = -1;
+   racy_clock::ticks = 0;
+   racy_clock::interrupt = []{
+      x.start_from_isr( 
+         typename timing::moment() + timing::duration::us( 10 ));
+   };
+   timing::wait( timing::duration::us( 100 ));
+
+   // due one tick after its epoch, not at the end of the sleep
+   HWCPP_ASSERT( x.at == 10000 + 1 );
+}
+
+int main(){
+   test all( "timer start from isr" );
+   check< callback_administration_double_linked >( "double linked" );
+   check< callback_administration_pairing_heap >( "pairing heap" );
+   check< callback_administration_timing_wheel >( "timing wheel" );
+   check_race< callback_administration_double_linked >( 
+      "start before the sleep, double linked" );
+   check_race< callback_administration_pairing_heap >( 
+      "start before the sleep, pairing heap" );
+   check_race< callback_administration_timing_wheel >( 
+      "start before the sleep, timing wheel" );
+}
@@ -0,0 +1,98 @@
+// ==========================================================================
+//
+// File      : test_timer_slack.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// timers started with slack fire within [ due, due + slack ], and
+// nearby deadlines are batched into fewer updates and sleeps
+
+#define HWCPP_CALLBACK_STATISTICS 1
+#define HWCPP_IDLE_STATISTICS 1
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <cstdlib>
+#include <vector>
+
+using namespace hwcpp;
+
+typedef host_sim<>::clock clk;
+typedef callback_statistics< timing_implementation< clk > > statistics;
+
+struct result {
+   unsigned int sleeps;
+   unsigned int ratio_100;
+};
+
+template< template< typename > class administration >
+result run( long long slack ){
+   typedef callback_implementation< clk, administration > timing;
+
+   struct timer : timing::template timer<> {
+      long long due, latest;
+      bool ok = true;
+      void function() override {
+         ok &= ( clk::virtual_now >= due ) && ( clk::virtual_now <= latest );
+      }
+   };
+
+   statistics::activations_total = 0;
+   statistics::batches_total = 0;
+   unsigned int sleeps = idle< clk >::n_sleeps;
+
+   std::vector< timer > timers( 100 );
+   srand( 2 );
+   for( auto & x : timers ){
+      long long d = 1000 + rand() % 50000;
+      x.due = clk::virtual_now + d;
+      x.latest = x.due + slack + 10;
+      x.start(
+         typename timing::duration( d ),
+         typename timing::duration( slack ));
+   }
+   timing::wait( timing::duration::us( 100 ));
+
+   for( auto & x : timers ){
+      HWCPP_ASSERT( x.ok );
+      HWCPP_ASSERT( x.statistics().activations == 1 );
+   }
+   return { idle< clk >::n_sleeps - sleeps, statistics::batching_ratio_100() };
+}
+
+template< template< typename > class administration >
+void check( const char * name, bool batches ){
+   test t( name );
+   result none = run< administration >( 0 );
+   result some = run< administration >( 2000 );
+   result more = run< administration >( 5000 );
+   HWCPP_ASSERT( none.ratio_100 == 100 );
+   HWCPP_ASSERT( some.sleeps < none.sleeps );
+   HWCPP_ASSERT( more.sleeps < some.sleeps );
+   if( batches ){
+      HWCPP_ASSERT( some.ratio_100 > 100 );
+      HWCPP_ASSERT( more.ratio_100 > some.ratio_100 );
+   }
+   std::cout
+      << "      sleeps (activations per batch) for 100 timers: "
+      << "no slack " << none.sleeps
+         << " (" << none.ratio_100 / 100.0 << "), "
+      << "2 us " << some.sleeps
+         << " (" << some.ratio_100 / 100.0 << "), "
+      << "5 us " << more.sleeps
+         << " (" << more.ratio_100 / 100.0 << ")\n";
+}
+
+int main(){
+   test all( "timer slack" );
+
+   // the double linked administration services one callback per update
+   check< callback_administration_double_linked >( "double linked", false );
+   check< callback_administration_pairing_heap >( "pairing heap", true );
+   check< callback_administration_timing_wheel >( "timing wheel", true );
+}
@@ -0,0 +1,94 @@
+// ==========================================================================
+//
+// File      : test_traced.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// traced<> counts the operations on pins and ports and records them
+// as a VCD waveform
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <sstream>
+#include <string>
+
+using namespace hwcpp;
+
+typedef host_sim<> target;
+typedef target::simulation timing;
+typedef trace_recorder< timing, 64 > recorder;
+
+typedef traced< target::pin_in_out< 0, 0 >, recorder > sclk;
+typedef traced< port_out_from_pins<
+   target::pin_in_out< 1, 0 >,
+   target::pin_in_out< 1, 1 >,
+   target::pin_in_out< 1, 2 >
+>, recorder > data;
+typedef traced< target::pin_in_out< 0, 1 > > counted;
+
+// a driver that wraps the pin and calls its init() again
+typedef pin_out_from< sclk > driver_sclk;
+
+int main(){
+   test all( "traced" );
+
+   sclk::init( "sclk" );
+   data::init( "data" );
+   counted::init();
+   driver_sclk::init();
+   sclk::direction_set_output();
+
+   {
+      test t( "one signal per traced pin or port" );
+      HWCPP_ASSERT( recorder::n_signals == 2 );
+      HWCPP_ASSERT( std::string( recorder::names[ 0 ] ) == "sclk" );
+      HWCPP_ASSERT( std::string( recorder::names[ 1 ] ) == "data" );
+   }
+
+   {
+      test t( "counters" );
+      for( int i = 0; i < 3; i++ ){
+         driver_sclk::set( 1 );
+         data::set( i );
+         timing::wait( timing::duration::us( 1 ));
+         driver_sclk::set( 0 );
+         timing::wait( timing::duration::us( 1 ));
+      }
+      sclk::get();
+      counted::set( 1 );
+      counted::get();
+      HWCPP_ASSERT( sclk::n_set == 6 );
+      HWCPP_ASSERT( sclk::n_get == 1 );
+      // one by the driver init(), one by the test
+      HWCPP_ASSERT( sclk::n_direction == 2 );
+      HWCPP_ASSERT( data::n_set == 3 );
+      HWCPP_ASSERT( counted::n_set == 1 );
+      HWCPP_ASSERT( counted::n_get == 1 );
+      HWCPP_ASSERT( recorder::n_events == 6 + 1 + 3 );
+   }
+
+   {
+      test t( "vcd" );
+      std::ostringstream s;
+      recorder::vcd( s );
+      std::string vcd = s.str();
+      HWCPP_ASSERT( vcd.find( "$var wire 1 ! sclk $end" ) != std::string::npos );
+      HWCPP_ASSERT( vcd.find( "$var wire 3 \" data $end" ) != std::string::npos );
+      HWCPP_ASSERT( vcd.find( "#0\n1!\nb000 \"\n#1000\n0!\n#2000\n1!\nb001 \"" )
+         != std::string::npos );
+   }
+
+   {
+      test t( "a later name renames the signal" );
+      sclk::init( "clock" );
+      HWCPP_ASSERT( recorder::n_signals == 2 );
+      HWCPP_ASSERT( std::string( recorder::names[ 0 ] ) == "clock" );
+      HWCPP_ASSERT( sclk::n_set == 0 );
+   }
+}
@@ -0,0 +1,125 @@
+// ==========================================================================
+//
+// File      : test_uart_in.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// uart_in<> receives a simulated serial waveform in virtual time at
+// several baudrates, with the sender's bit time off by up to 3.5%,
+// and drops the chars with a bad stop bit
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <cstdlib>
+#include <string>
+
+using namespace hwcpp;
+
+typedef virtual_timing<> timing;
+typedef host_sim_pin_in_out< 0, 0 > rx;
+
+// drives the rx pin with data, starting at t0, idle before and after
+struct sender : host_sim_peripheral {
+   std::string data;
+   double bit_ns;
+   long long t0 = 5000;
+   int stop_bits = 1;
+
+   // the chars with a low stop bit
+   int bad_stop_every = 0;
+
+   bool level( long long t ){
+      if( t < t0 ){
+         return true;
+      }
+      double frame = ( 9 + stop_bits ) * bit_ns;
+      long long k = (long long)(( t - t0 ) / frame );
+      if( k >= (long long) data.size() ){
+         return true;
+      }
+      int b = int((( t - t0 ) - k * frame ) / bit_ns );
+      if( b == 0 ){
+         return false;
+      }
+      if( b <= 8 ){
+         return ( data[ k ] >> ( b - 1 )) & 1;
+      }
+      return ! (( b == 9 ) && bad_stop_every && ( k % bad_stop_every == 3 ));
+   }
+
+   void update() override {
+      host_sim_register< 0 >::drive( 0, level( virtual_clock::ticks() ));
+   }
+};
+
+// receive 200 random chars, sent with the bit time off by skew
+template< unsigned int baudrate >
+void check(
+   double skew,
+   int stop_bits = 1,
+   int bad_stop_every = 0
+){
+   typedef uart_in< rx, timing, baudrate > uart;
+   virtual_clock::ticks() = 0;
+
+   sender s;
+   s.bit_ns = 1e9 / ( baudrate * ( 1 + skew ));
+   s.stop_bits = stop_bits;
+   s.bad_stop_every = bad_stop_every;
+   srand( baudrate );
+   std::string expect;
+   for( int i = 0; i < 200; i++ ){
+      s.data += char( rand() );
+      if( ! bad_stop_every || ( i % bad_stop_every != 3 )){
+         expect += s.data.back();
+      }
+   }
+   s.update();
+   uart::init();
+
+   std::string got;
+   long long end = s.t0 + (long long)(( 10 + stop_bits ) * s.bit_ns * 201 );
+   while( timing::now().raw() < end ){
+      if( ! uart::get_will_block() ){
+         got += uart::get();
+      } else {
+         timing::wait( timing::duration::ns( 200 ));
+      }
+   }
+
+   HWCPP_ASSERT( got == expect );
+   HWCPP_ASSERT( uart::framing_errors == s.data.size() - expect.size() );
+   HWCPP_ASSERT( uart::overflows == 0 );
+}
+
+int main(){
+   test all( "uart_in" );
+
+   struct { double skew; const char * name; } skews[] = {
+      { -0.035, "bit time 3.5% short" },
+      { -0.02,  "bit time 2% short" },
+      {  0.0,   "exact bit time" },
+      {  0.02,  "bit time 2% long" },
+      {  0.035, "bit time 3.5% long" }
+   };
+   for( auto & x : skews ){
+      test t( x.name );
+      check< 9600 >( x.skew );
+      check< 19200 >( x.skew );
+      check< 115200 >( x.skew );
+   }
+
+   {
+      // the low stop bit hides the next start edge, so the receiver
+      // needs a second stop bit to find it
+      test t( "bad stop bits" );
+      check< 19200 >( 0.0, 2, 10 );
+      check< 115200 >( 0.0, 2, 10 );
+   }
+}
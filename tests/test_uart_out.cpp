@@ -0,0 +1,88 @@
+// ==========================================================================
+//
+// File      : test_uart_out.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// the edges that uart_out<> produces, captured in virtual time, are
+// at whole bit times from the start edge (within a tick), at baudrates
+// up to 921600, and form the right frame
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <cmath>
+
+using namespace hwcpp;
+
+typedef virtual_timing<> timing;
+typedef host_sim_pin_in_out< 0, 1 > tx;
+typedef edge_capture< tx, timing, 1024 > capture;
+
+struct probe : host_sim_peripheral {
+   void update() override { capture::sample(); }
+};
+
+template< unsigned int baudrate >
+void check( const char * name ){
+   test t( name );
+   typedef uart_out< tx, timing, baudrate > uart;
+   capture::init();
+   uart::init();
+   tx::direction_set_output();
+   probe p;
+   timing::wait( timing::duration::us( 100 ));
+
+   const double bit = 1e9 / baudrate;
+   double worst = 0;
+   for( const char * m = "\x55\x0F\xF0\xAA\x01\x80\xFF"; *m; m++ ){
+      capture::event e;
+      while( capture::get( e )){}
+      uart::put( *m );
+
+      // rebuild the frame from the edges
+      long long start = -1;
+      unsigned int frame = 0, level = 0;
+      int position = 0;
+      while( capture::get( e )){
+         if( start < 0 ){
+            start = e.time.raw();
+            HWCPP_ASSERT( e.value == 0 );
+            continue;
+         }
+         double bits = ( e.time.raw() - start ) / bit;
+         int b = (int) std::round( bits );
+         worst = std::max( worst, std::fabs( bits - b ) * bit );
+         for( ; position < b; position++ ){
+            frame |= level << position;
+         }
+         level = e.value;
+      }
+      for( ; position < 11; position++ ){
+         frame |= level << position;
+      }
+      HWCPP_ASSERT( frame == (( 0x300U | (unsigned char) *m ) << 1 ));
+
+      // put() returns at the end of the stop bits
+      HWCPP_ASSERT( timing::now().raw() - start >= (long long)( 11 * bit ));
+   }
+
+   // the error of an edge is at most the rounding to a tick
+   HWCPP_ASSERT( worst <= 2.0 );
+   std::cout
+      << "      worst edge error " << worst << " ns, "
+      << 100 * worst / bit << "% of a bit\n";
+}
+
+int main(){
+   test all( "uart_out" );
+   check< 9600 >( "9600 baud" );
+   check< 57600 >( "57600 baud" );
+   check< 115200 >( "115200 baud" );
+   check< 921600 >( "921600 baud" );
+}
@@ -0,0 +1,108 @@
+// ==========================================================================
+//
+// File      : test_virtual_timing.cpp
+// Part of   : hwcpp library (www.voti.nl/hwcpp)
+// Copyright : wouter@voti.nl 2014
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+//
+// ==========================================================================
+
+// virtual_timing<> fires each callback at exactly its epoch + 1 tick,
+// in deadline order, with the same result on every run and for every
+// administration, and simulates minutes in a fraction of a second;
+// a wait with a margin services the callbacks until the margin before
+// its end
+
+#include "hwcpp/targets/host_sim.hpp"
+#include "hwcpp/core/test.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace hwcpp;
+
+// the order in which the timers fired, as a hash
+template< template< typename > class administration >
+unsigned long long run( const char * name ){
+   test t( name );
+   typedef virtual_timing< administration > timing;
+   virtual_clock::ticks() = 0;
+   static std::vector< long long > fired;
+   fired.clear();
+
+   struct timer : timing::template timer<> {
+      long long epoch;
+      bool exact = true;
+      void function() override {
+         fired.push_back( epoch );
+         exact &= ( timing::now().raw() == epoch + 1 );
+      }
+   };
+   struct ms_clock : timing::template clock< typename timing::template ms< 1 >> {
+      long long n = 0;
+      void function() override { n++; }
+   };
+
+   std::vector< timer > timers( 500 );
+   srand( 3 );
+   for( auto & x : timers ){
+      x.epoch = 1 + rand() % 10000000;
+      x.start( typename timing::moment() + typename timing::duration( x.epoch ));
+   }
+   ms_clock c;
+   auto t0 = std::chrono::steady_clock::now();
+   timing::wait( timing::duration::ms( 600LL * 1000 ));
+   auto t1 = std::chrono::steady_clock::now();
+
+   HWCPP_ASSERT( fired.size() == timers.size() );
+   for( auto & x : timers ){
+      HWCPP_ASSERT( x.exact );
+   }
+   unsigned long long hash = 0;
+   for( size_t i = 0; i < fired.size(); i++ ){
+      HWCPP_ASSERT(( i == 0 ) || ( fired[ i ] >= fired[ i - 1 ] ));
+      hash = hash * 31 + fired[ i ];
+   }
+   HWCPP_ASSERT( c.n == 600LL * 1000 - 1 );
+   HWCPP_ASSERT( timing::now().raw() == 600LL * 1000 * 1000 * 1000 );
+   std::cout
+      << "      10 simulated minutes took "
+      << std::chrono::duration< double >( t1 - t0 ).count() << " s\n";
+   return hash;
+}
+
+int main(){
+   test all( "virtual timing" );
+   unsigned long long h = run< callback_administration_pairing_heap >(
+      "pairing heap" );
+   HWCPP_ASSERT( h == run< callback_administration_pairing_heap >(
+      "pairing heap, again" ));
+   HWCPP_ASSERT( h == run< callback_administration_timing_wheel >(
+      "timing wheel" ));
+   HWCPP_ASSERT( h == run< callback_administration_double_linked >(
+      "double linked" ));
+
+   {
+      test t( "margin" );
+      typedef virtual_timing<> timing;
+      virtual_clock::ticks() = 0;
+      struct timer : timing::timer<> {
+         long long at = -1;
+         void function() override { at = timing::now().raw(); }
+      } early, late;
+      early.start( timing::duration::us( 50 ));
+      late.start( timing::duration::us( 95 ));
+
+      // the timer within the margin waits for the next wait
+      timing::wait( timing::duration::us( 100 ), timing::duration::us( 10 ));
+      HWCPP_ASSERT( early.at == 50000 + 1 );
+      HWCPP_ASSERT( late.at == -1 );
+      long long end = timing::now().raw();
+      HWCPP_ASSERT( end == 100000 );
+      timing::wait( timing::duration::us( 1 ));
+      HWCPP_ASSERT( late.at >= end );
+   }
+}